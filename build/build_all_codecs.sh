@@ -1,4 +1,20 @@
-# Current build uses emscripten at commit df11c6f1fd1636a355b83a1c48b3a890596e6a32
+# Needs emscripten 3.1.45 (emsdk install 3.1.45 && emsdk activate 3.1.45) or
+# newer: --arch=wasm builds with -msimd128 against wasm_simd128.h, and the link
+# uses MAXIMUM_MEMORY, EXPORTED_RUNTIME_METHODS and WASM_ASYNC_COMPILATION,
+# none of which the fastcomp-era emscripten this was first built with has.
+
+# The heap starts at 32MB and grows on demand up to MAXIMUM_MEMORY (1GB
+# unless set in the environment), so large inputs no longer run out of memory
+# but a runaway job still fails instead of taking the whole tab down.
+MAXIMUM_MEMORY=${MAXIMUM_MEMORY:-1073741824}
+
+# SIMD128=0 builds a module for engines without WebAssembly SIMD support: no
+# -msimd128 for x264 (--disable-asm) or ffmpeg (--disable-simd128).
+if [ "$SIMD128" = "0" ]; then
+  X264_SIMD="--disable-asm"
+  FFMPEG_SIMD="--disable-simd128"
+fi
+
 echo "Beginning Build:"
 
 rm -r dist
@@ -38,9 +54,9 @@ cd ..
 # x264-snapshot-20140501-2245
 cd x264
 make clean
-emconfigure ./configure --disable-thread --disable-asm \
-  --host=i686-pc-linux-gnu \
-  --disable-cli --enable-static --disable-gpl --prefix=$(pwd)/../dist
+emconfigure ./configure --disable-thread \
+  --host=wasm32-unknown-linux-gnu \
+  --disable-cli --enable-static --disable-gpl --prefix=$(pwd)/../dist $X264_SIMD
 emmake make
 emmake make install
 cd ..
@@ -48,21 +64,32 @@ cd ..
 cd ffmpeg
 
 make clean
-emconfigure ./configure --cc="emcc" --prefix=$(pwd)/../dist --extra-cflags="-I$(pwd)/../dist/include -v" --enable-cross-compile --target-os=none --arch=x86_32 --cpu=generic \
-    --disable-ffplay --disable-ffprobe --disable-ffserver --disable-asm --disable-doc --disable-devices --disable-pthreads --disable-w32threads --disable-network \
-    --disable-hwaccels --disable-parsers --disable-bsfs --disable-debug --disable-protocols --disable-indevs --disable-outdevs --enable-protocol=file \
+# Parsers and bitstream filters needed for -c copy between containers (matroska,
+# webm, mp4/mov, ogg): they fill in the codec parameters the demuxers leave out
+# and convert h264/aac between their mp4 and raw/ADTS forms.
+PARSERS=h264,hevc,mpeg4video,mpegvideo,vp8,vp9,aac,aac_latm,ac3,mpegaudio,vorbis,opus,flac
+BSFS=h264_mp4toannexb,aac_adtstoasc,remove_extradata
+# SIMD128 kernels are enabled when emcc accepts -msimd128, unless SIMD128=0.
+emconfigure ./configure --cc="emcc" --prefix=$(pwd)/../dist --extra-cflags="-I$(pwd)/../dist/include -v" --enable-cross-compile --target-os=none --arch=wasm --cpu=generic $FFMPEG_SIMD \
+    --disable-ffplay --disable-ffprobe --disable-ffserver --disable-inline-asm --disable-yasm --disable-doc --disable-devices --disable-pthreads --disable-w32threads --disable-network \
+    --disable-hwaccels --disable-parsers --enable-parser=$PARSERS --disable-bsfs --enable-bsf=$BSFS --disable-debug --disable-protocols --disable-indevs --disable-outdevs --enable-protocol=file --enable-protocol=jsstream \
     --enable-libvpx --enable-gpl --extra-libs="$(pwd)/../dist/lib/libx264.a $(pwd)/../dist/lib/libvpx.a"
 
 # If we --enable-libx264 there is an error.  Instead just act like it is there, extra-libs seems to work.
 sed -i '' 's/define CONFIG_LIBX264 0/define CONFIG_LIBX264 1/' config.h
 sed -i '' 's/define CONFIG_LIBX264_ENCODER 0/define CONFIG_LIBX264_ENCODER 1/' config.h
 sed -i '' 's/define CONFIG_LIBX264RGB_ENCODER 0/define CONFIG_LIBX264RGB_ENCODER 1/' config.h
-sed -i '' 's/define CONFIG_H264_PARSER 0/define CONFIG_H264_PARSER 1/' config.h
 
 sed -i '' 's/\!CONFIG_LIBX264=yes/CONFIG_LIBX264=yes/' config.mak
 sed -i '' 's/\!CONFIG_LIBX264_ENCODER=yes/CONFIG_LIBX264_ENCODER=yes/' config.mak
 sed -i '' 's/\!CONFIG_LIBX264RGB_ENCODER=yes/CONFIG_LIBX264RGB_ENCODER=yes/' config.mak
-sed -i '' 's/\!CONFIG_H264_PARSER=yes/CONFIG_H264_PARSER=yes/' config.mak
+
+# What the module was built with, for labelling the perf-tests results.
+if grep -q "define HAVE_SIMD128 1" config.h; then
+  echo wasm-simd128 > ../ffmpeg-all-codecs.target
+else
+  echo wasm > ../ffmpeg-all-codecs.target
+fi
 
 make
 make install
@@ -79,8 +106,10 @@ cp dist/lib/libz.a dist/libz.bc
 cp dist/lib/libx264.a dist/libx264.bc
 cp ffmpeg/ffmpeg dist/ffmpeg.bc
 
+# main() only runs under node; in the browser every job calls ffmpeg_run_job()
+# on the same module (see ffmpeg_post.js), so it has to be exported.
 cd dist
-emcc -s OUTLINING_LIMIT=100000 -s VERBOSE=1 -s TOTAL_MEMORY=33554432 -O2 -v ffmpeg.bc libx264.bc  libvpx.bc libz.bc -o ../ffmpeg-all-codecs.js --pre-js ../ffmpeg_pre.js --post-js ../ffmpeg_post.js
+emcc -s VERBOSE=1 -s TOTAL_MEMORY=33554432 -s ALLOW_MEMORY_GROWTH=1 -s MAXIMUM_MEMORY=$MAXIMUM_MEMORY -O2 -v -s EXPORTED_FUNCTIONS="['_main','_ffmpeg_run_job','_ffmpeg_thumbnails','_malloc','_free']" -s EXPORTED_RUNTIME_METHODS="['FS','stringToUTF8','lengthBytesUTF8']" -s WASM_ASYNC_COMPILATION=0 ffmpeg.bc libx264.bc  libvpx.bc libz.bc -o ../ffmpeg-all-codecs.js --js-library ../ffmpeg_jsstream.js --pre-js ../ffmpeg_pre.js --post-js ../ffmpeg_post.js
 cd ..
 
 
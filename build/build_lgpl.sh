@@ -1,4 +1,12 @@
-# Current build uses emscripten at commit df11c6f1fd1636a355b83a1c48b3a890596e6a32
+# Needs emscripten 3.1.45 (emsdk install 3.1.45 && emsdk activate 3.1.45) or
+# newer: --arch=wasm builds with -msimd128 against wasm_simd128.h, and the link
+# uses MAXIMUM_MEMORY, EXPORTED_RUNTIME_METHODS and WASM_ASYNC_COMPILATION,
+# none of which the fastcomp-era emscripten this was first built with has.
+
+# The heap starts at 32MB and grows on demand up to MAXIMUM_MEMORY (1GB
+# unless set in the environment), so large inputs no longer run out of memory
+# but a runaway job still fails instead of taking the whole tab down.
+MAXIMUM_MEMORY=${MAXIMUM_MEMORY:-1073741824}
 
 echo "Beginning Build:"
 
@@ -17,9 +25,16 @@ cd ffmpeg
 #--enable-small
 
 make clean
-emconfigure ./configure --cc="emcc" --prefix=$(pwd)/../dist --enable-cross-compile --target-os=none --arch=x86_32 --cpu=generic \
-    --disable-ffplay --disable-ffprobe --disable-ffserver --disable-asm --disable-doc --disable-devices --disable-pthreads --disable-w32threads --disable-network \
-    --disable-hwaccels --disable-parsers --disable-bsfs --disable-debug --disable-protocols --disable-indevs --disable-outdevs --enable-protocol=file \
+# Parsers and bitstream filters needed for -c copy between containers (matroska,
+# webm, mp4/mov, ogg): they fill in the codec parameters the demuxers leave out
+# and convert h264/aac between their mp4 and raw/ADTS forms.
+PARSERS=h264,hevc,mpeg4video,mpegvideo,vp8,vp9,aac,aac_latm,ac3,mpegaudio,vorbis,opus,flac
+BSFS=h264_mp4toannexb,aac_adtstoasc,remove_extradata
+# SIMD128 kernels are enabled when emcc accepts -msimd128; pass --disable-simd128
+# to build a module for engines without WebAssembly SIMD support.
+emconfigure ./configure --cc="emcc" --prefix=$(pwd)/../dist --enable-cross-compile --target-os=none --arch=wasm --cpu=generic \
+    --disable-ffplay --disable-ffprobe --disable-ffserver --disable-inline-asm --disable-yasm --disable-doc --disable-devices --disable-pthreads --disable-w32threads --disable-network \
+    --disable-hwaccels --disable-parsers --enable-parser=$PARSERS --disable-bsfs --enable-bsf=$BSFS --disable-debug --disable-protocols --disable-indevs --disable-outdevs --enable-protocol=file --enable-protocol=jsstream \
 
 make
 make install
@@ -34,7 +49,7 @@ rm *.bc
 cp lib/libz.a dist/libz.bc
 cp ../ffmpeg/ffmpeg ffmpeg.bc
 
-emcc -s OUTLINING_LIMIT=100000 -s VERBOSE=1 -s TOTAL_MEMORY=33554432 -O2 -v ffmpeg.bc -o ../ffmpeg.js --pre-js ../ffmpeg_pre.js --post-js ../ffmpeg_post.js
+emcc -s VERBOSE=1 -s TOTAL_MEMORY=33554432 -s ALLOW_MEMORY_GROWTH=1 -s MAXIMUM_MEMORY=$MAXIMUM_MEMORY -O2 -v -s EXPORTED_FUNCTIONS="['_main','_ffmpeg_run_job','_ffmpeg_thumbnails','_malloc','_free']" -s EXPORTED_RUNTIME_METHODS="['FS','stringToUTF8','lengthBytesUTF8']" -s WASM_ASYNC_COMPILATION=0 ffmpeg.bc -o ../ffmpeg.js --js-library ../ffmpeg_jsstream.js --pre-js ../ffmpeg_pre.js --post-js ../ffmpeg_post.js
 
 cd ..
 
@@ -0,0 +1,95 @@
+# Same codecs as build_all_codecs.sh, built against emscripten's pthreads
+# (SharedArrayBuffer + worker pool) instead of with threading compiled out.
+# Needs emscripten 3.1.45 or newer, as build_all_codecs.sh does (USE_PTHREADS
+# and a PTHREAD_POOL_SIZE that is read from Module at startup), and the page
+# has to be served cross-origin isolated for SharedArrayBuffer to be available.
+
+# The heap starts at 32MB and grows on demand up to MAXIMUM_MEMORY (1GB
+# unless set in the environment), so large inputs no longer run out of memory
+# but a runaway job still fails instead of taking the whole tab down.
+MAXIMUM_MEMORY=${MAXIMUM_MEMORY:-1073741824}
+
+echo "Beginning Build:"
+
+rm -r dist
+mkdir -p dist
+
+export CFLAGS="-pthread"
+export LDFLAGS="-pthread"
+
+cd zlib
+make clean
+emconfigure ./configure --prefix=$(pwd)/../dist --64
+emmake make
+emmake make install
+cd ..
+
+cd libvpx
+make clean
+emconfigure ./configure --prefix=$(pwd)/../dist --disable-examples --disable-docs \
+  --disable-runtime-cpu-detect --enable-multithread --disable-optimizations \
+  --target=generic-gnu
+emmake make
+emmake make install
+cd ..
+
+# x264-snapshot-20140501-2245
+cd x264
+make clean
+emconfigure ./configure --extra-cflags="-pthread" --extra-ldflags="-pthread" \
+  --host=wasm32-unknown-linux-gnu \
+  --disable-cli --enable-static --disable-gpl --prefix=$(pwd)/../dist
+emmake make
+emmake make install
+cd ..
+
+cd ffmpeg
+
+make clean
+# Parsers and bitstream filters needed for -c copy between containers (matroska,
+# webm, mp4/mov, ogg): they fill in the codec parameters the demuxers leave out
+# and convert h264/aac between their mp4 and raw/ADTS forms.
+PARSERS=h264,hevc,mpeg4video,mpegvideo,vp8,vp9,aac,aac_latm,ac3,mpegaudio,vorbis,opus,flac
+BSFS=h264_mp4toannexb,aac_adtstoasc,remove_extradata
+# SIMD128 kernels are enabled when emcc accepts -msimd128; pass --disable-simd128
+# to build a module for engines without WebAssembly SIMD support.
+emconfigure ./configure --cc="emcc" --prefix=$(pwd)/../dist --extra-cflags="-I$(pwd)/../dist/include -pthread -v" --extra-ldflags="-pthread" --enable-cross-compile --target-os=none --arch=wasm --cpu=generic \
+    --disable-ffplay --disable-ffprobe --disable-ffserver --disable-inline-asm --disable-yasm --disable-doc --disable-devices --enable-pthreads --disable-w32threads --disable-network \
+    --disable-hwaccels --disable-parsers --enable-parser=$PARSERS --disable-bsfs --enable-bsf=$BSFS --disable-debug --disable-protocols --disable-indevs --disable-outdevs --enable-protocol=file --enable-protocol=jsstream \
+    --enable-libvpx --enable-gpl --extra-libs="$(pwd)/../dist/lib/libx264.a $(pwd)/../dist/lib/libvpx.a"
+
+# If we --enable-libx264 there is an error.  Instead just act like it is there, extra-libs seems to work.
+sed -i '' 's/define CONFIG_LIBX264 0/define CONFIG_LIBX264 1/' config.h
+sed -i '' 's/define CONFIG_LIBX264_ENCODER 0/define CONFIG_LIBX264_ENCODER 1/' config.h
+sed -i '' 's/define CONFIG_LIBX264RGB_ENCODER 0/define CONFIG_LIBX264RGB_ENCODER 1/' config.h
+
+sed -i '' 's/\!CONFIG_LIBX264=yes/CONFIG_LIBX264=yes/' config.mak
+sed -i '' 's/\!CONFIG_LIBX264_ENCODER=yes/CONFIG_LIBX264_ENCODER=yes/' config.mak
+sed -i '' 's/\!CONFIG_LIBX264RGB_ENCODER=yes/CONFIG_LIBX264RGB_ENCODER=yes/' config.mak
+
+make
+make install
+
+cd ..
+
+rm dist/*.bc
+
+cp dist/lib/libvpx.a dist/libvpx.bc
+cp dist/lib/libz.a dist/libz.bc
+cp dist/lib/libx264.a dist/libx264.bc
+cp ffmpeg/ffmpeg dist/ffmpeg.bc
+
+# The worker pool is sized at startup from Module['pthreadPoolSize'], which
+# ffmpeg_instance() derives from its "threads" and "maxInputs" options (see
+# ffmpeg_pre.js).  The pool loads asynchronously, so jobs wait for
+# instance.ready().
+# emcc warns that growth makes JS heap access slower with pthreads; the JS
+# side only touches the heap to copy job inputs and outputs.
+cd dist
+emcc -s VERBOSE=1 -s TOTAL_MEMORY=33554432 -s ALLOW_MEMORY_GROWTH=1 -s MAXIMUM_MEMORY=$MAXIMUM_MEMORY -O2 -v -s EXPORTED_FUNCTIONS="['_main','_ffmpeg_run_job','_ffmpeg_thumbnails','_malloc','_free']" -s EXPORTED_RUNTIME_METHODS="['FS','stringToUTF8','lengthBytesUTF8']" -s WASM_ASYNC_COMPILATION=0 -pthread -s USE_PTHREADS=1 \
+  -s PTHREAD_POOL_SIZE='Module["pthreadPoolSize"]||1' \
+  ffmpeg.bc libx264.bc  libvpx.bc libz.bc -o ../ffmpeg-threaded.js --js-library ../ffmpeg_jsstream.js --pre-js ../ffmpeg_pre.js --post-js ../ffmpeg_post.js
+cd ..
+
+
+echo "Finished Build"
@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <limits.h>
+#include <setjmp.h>
 #include <stdint.h>
 
 #if HAVE_ISATTY
@@ -58,6 +59,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/timestamp.h"
 #include "libavutil/bprint.h"
+#include "libavutil/cpu.h"
 #include "libavutil/time.h"
 #include "libavutil/threadmessage.h"
 #include "libavformat/os_support.h"
@@ -129,7 +131,18 @@ static int nb_frames_drop = 0;
 static int64_t decode_error_stat[2];
 
 static int current_time;
+static int64_t last_report_time = -1;
+static int64_t last_key_time;
+static int qp_histogram[52];
 AVIOContext *progress_avio = NULL;
+AVIOContext *stats_json_avio = NULL;
+static int64_t job_start_time;
+static int64_t last_stats_json_time;
+static int64_t job_start_allocs;
+/* libavutil settings changed by -cpuflags and -max_alloc, as they were
+ * before the first job */
+static int job_defaults_saved;
+static int default_cpu_flags;
 
 static uint8_t *subtitle_out;
 
@@ -424,6 +437,79 @@ static int decode_interrupt_cb(void *ctx)
 
 const AVIOInterruptCB int_cb = { decode_interrupt_cb, NULL };
 
+static const char *stats_type(AVCodecContext *avctx)
+{
+    const char *type = av_get_media_type_string(avctx->codec_type);
+    return type ? type : "unknown";
+}
+
+/**
+ * Write one -stats_json report: a line with a JSON object holding the time
+ * spent so far in each stage of every stream (in seconds), frame and packet
+ * counts, the current and peak size of the av_malloc() heap and the number
+ * of blocks allocated on it during the job.
+ */
+static void print_stats_json(int is_last_report)
+{
+    AVBPrint buf;
+    int64_t cur_time = av_gettime_relative();
+    int64_t mem_current, mem_peak;
+    const char *sep = "";
+    int i;
+
+    if (!stats_json_avio)
+        return;
+    if (!is_last_report && cur_time - last_stats_json_time < stats_json_period * 1000000)
+        return;
+    last_stats_json_time = cur_time;
+
+    av_mem_stats(&mem_current, &mem_peak);
+
+    av_bprint_init(&buf, 0, AV_BPRINT_SIZE_UNLIMITED);
+    av_bprintf(&buf, "{\"final\":%s,\"time\":%.6f,"
+               "\"memory\":{\"current\":%"PRId64",\"peak\":%"PRId64",\"allocs\":%"PRId64"},\"inputs\":[",
+               is_last_report ? "true" : "false", (cur_time - job_start_time) / 1000000.0,
+               mem_current, mem_peak, av_mem_nb_allocs() - job_start_allocs);
+    for (i = 0; i < nb_input_streams; i++) {
+        InputStream *ist = input_streams[i];
+        if (!ist || !ist->st)
+            continue;
+        av_bprintf(&buf, "%s{\"file\":%d,\"stream\":%d,\"type\":\"%s\",\"codec\":\"%s\","
+                   "\"packets\":%"PRIu64",\"frames\":%"PRIu64","
+                   "\"demux_time\":%.6f,\"decode_time\":%.6f,\"filter_time\":%.6f}",
+                   sep, ist->file_index, ist->st->index,
+                   stats_type(ist->st->codec), avcodec_get_name(ist->st->codec->codec_id),
+                   ist->nb_packets, ist->frames_decoded,
+                   ist->demux_time / 1000000.0, ist->decode_time / 1000000.0,
+                   ist->filter_time / 1000000.0);
+        sep = ",";
+    }
+    av_bprintf(&buf, "],\"outputs\":[");
+    sep = "";
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+        if (!ost || !ost->st)
+            continue;
+        av_bprintf(&buf, "%s{\"file\":%d,\"stream\":%d,\"type\":\"%s\",\"codec\":\"%s\","
+                   "\"frames\":%"PRIu64",\"packets\":%"PRIu64","
+                   "\"filter_time\":%.6f,\"encode_time\":%.6f,\"mux_time\":%.6f}",
+                   sep, ost->file_index, ost->index,
+                   stats_type(ost->st->codec),
+                   ost->stream_copy ? "copy" : avcodec_get_name(ost->st->codec->codec_id),
+                   ost->frames_encoded, ost->packets_written,
+                   ost->filter_time / 1000000.0, ost->encode_time / 1000000.0,
+                   ost->mux_time / 1000000.0);
+        sep = ",";
+    }
+    av_bprintf(&buf, "]}\n");
+
+    if (av_bprint_is_complete(&buf)) {
+        avio_write(stats_json_avio, buf.str, buf.len);
+        avio_flush(stats_json_avio);
+    }
+    av_bprint_finalize(&buf, NULL);
+}
+
 static void ffmpeg_cleanup(int ret)
 {
     int i, j;
@@ -433,6 +519,9 @@ static void ffmpeg_cleanup(int ret)
         printf("bench: maxrss=%ikB\n", maxrss);
     }
 
+    /* also written when the job failed, with whatever was done until then */
+    print_stats_json(1);
+
     for (i = 0; i < nb_filtergraphs; i++) {
         FilterGraph *fg = filtergraphs[i];
         avfilter_graph_free(&fg->graph);
@@ -451,6 +540,7 @@ static void ffmpeg_cleanup(int ret)
         av_freep(&filtergraphs[i]);
     }
     av_freep(&filtergraphs);
+    nb_filtergraphs = 0;
 
     av_freep(&subtitle_out);
 
@@ -512,16 +602,23 @@ static void ffmpeg_cleanup(int ret)
 
     if (vstats_file)
         fclose(vstats_file);
-    av_free(vstats_filename);
+    vstats_file = NULL;
+    av_freep(&vstats_filename);
+    avio_closep(&progress_avio);
+    avio_closep(&stats_json_avio);
 
     av_freep(&input_streams);
     av_freep(&input_files);
     av_freep(&output_streams);
     av_freep(&output_files);
+    nb_input_streams  = nb_input_files  = 0;
+    nb_output_streams = nb_output_files = 0;
 
+    ffmpeg_uninit_parse_options();
     uninit_opts();
 
     avformat_network_deinit();
+    av_mem_stats_enable(0);
 
     if (received_sigterm) {
         av_log(NULL, AV_LOG_INFO, "Received signal %d: terminating.\n",
@@ -563,6 +660,19 @@ static void update_benchmark(const char *fmt, ...)
     }
 }
 
+/* Stage timers for -stats_json. They cost a clock read each, so they only
+ * run when a report was requested. */
+static int64_t stage_start(void)
+{
+    return stats_json_avio ? av_gettime_relative() : 0;
+}
+
+static void stage_end(int64_t *total, int64_t start)
+{
+    if (stats_json_avio)
+        *total += av_gettime_relative() - start;
+}
+
 static void close_all_output_streams(OutputStream *ost, OSTFinished this_stream, OSTFinished others)
 {
     int i;
@@ -576,6 +686,7 @@ static void write_frame(AVFormatContext *s, AVPacket *pkt, OutputStream *ost)
 {
     AVBitStreamFilterContext *bsfc = ost->bitstream_filters;
     AVCodecContext          *avctx = ost->st->codec;
+    int64_t mux_start;
     int ret;
 
     if ((avctx->codec_type == AVMEDIA_TYPE_VIDEO && video_sync_method == VSYNC_DROP) ||
@@ -606,7 +717,7 @@ static void write_frame(AVFormatContext *s, AVPacket *pkt, OutputStream *ost)
                                            &new_pkt.data, &new_pkt.size,
                                            pkt->data, pkt->size,
                                            pkt->flags & AV_PKT_FLAG_KEY);
-        if(a == 0 && new_pkt.data != pkt->data && new_pkt.destruct) {
+        if(a == 0 && new_pkt.data != pkt->data && (new_pkt.destruct || new_pkt.buf)) {
             uint8_t *t = av_malloc(new_pkt.size + FF_INPUT_BUFFER_PADDING_SIZE); //the new should be a subset of the old so cannot overflow
             if(t) {
                 memcpy(t, new_pkt.data, new_pkt.size);
@@ -686,7 +797,9 @@ static void write_frame(AVFormatContext *s, AVPacket *pkt, OutputStream *ost)
               );
     }
 
+    mux_start = stage_start();
     ret = av_interleaved_write_frame(s, pkt);
+    stage_end(&ost->mux_time, mux_start);
     if (ret < 0) {
         print_error("av_interleaved_write_frame()", ret);
         main_return_code = 1;
@@ -725,6 +838,7 @@ static void do_audio_out(AVFormatContext *s, OutputStream *ost,
     AVCodecContext *enc = ost->enc_ctx;
     AVPacket pkt;
     int got_packet = 0;
+    int64_t encode_start;
 
     av_init_packet(&pkt);
     pkt.data = NULL;
@@ -748,10 +862,12 @@ static void do_audio_out(AVFormatContext *s, OutputStream *ost,
                enc->time_base.num, enc->time_base.den);
     }
 
+    encode_start = stage_start();
     if (avcodec_encode_audio2(enc, &pkt, frame, &got_packet) < 0) {
         av_log(NULL, AV_LOG_FATAL, "Audio encoding failed (avcodec_encode_audio2)\n");
         exit_program(1);
     }
+    stage_end(&ost->encode_time, encode_start);
     update_benchmark("encode_audio %d.%d", ost->file_index, ost->index);
 
     if (got_packet) {
@@ -860,6 +976,7 @@ static void do_video_out(AVFormatContext *s,
     double sync_ipts, delta;
     double duration = 0;
     int frame_size = 0;
+    int64_t encode_start;
     InputStream *ist = NULL;
 
     if (ost->source_index >= 0)
@@ -1033,7 +1150,9 @@ static void do_video_out(AVFormatContext *s,
 
         ost->frames_encoded++;
 
+        encode_start = stage_start();
         ret = avcodec_encode_video2(enc, &pkt, in_picture, &got_packet);
+        stage_end(&ost->encode_time, encode_start);
         update_benchmark("encode_video %d.%d", ost->file_index, ost->index);
         if (ret < 0) {
             av_log(NULL, AV_LOG_FATAL, "Video encoding failed\n");
@@ -1166,8 +1285,10 @@ static int reap_filters(void)
         filtered_frame = ost->filtered_frame;
 
         while (1) {
+            int64_t filter_start = stage_start();
             ret = av_buffersink_get_frame_flags(filter, filtered_frame,
                                                AV_BUFFERSINK_FLAG_NO_REQUEST);
+            stage_end(&ost->filter_time, filter_start);
             if (ret < 0) {
                 if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
                     av_log(NULL, AV_LOG_WARNING,
@@ -1345,21 +1466,19 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
     int frame_number, vid, i;
     double bitrate;
     int64_t pts = INT64_MIN;
-    static int64_t last_time = -1;
-    static int qp_histogram[52];
     int hours, mins, secs, us;
 
     if (!print_stats && !is_last_report && !progress_avio)
         return;
 
     if (!is_last_report) {
-        if (last_time == -1) {
-            last_time = cur_time;
+        if (last_report_time == -1) {
+            last_report_time = cur_time;
             return;
         }
-        if ((cur_time - last_time) < 500000)
+        if ((cur_time - last_report_time) < 500000)
             return;
-        last_time = cur_time;
+        last_report_time = cur_time;
     }
 
 
@@ -1538,12 +1657,15 @@ static void flush_encoders(void)
                 AVPacket pkt;
                 int pkt_size;
                 int got_packet;
+                int64_t encode_start;
                 av_init_packet(&pkt);
                 pkt.data = NULL;
                 pkt.size = 0;
 
                 update_benchmark(NULL);
+                encode_start = stage_start();
                 ret = encode(enc, &pkt, NULL, &got_packet);
+                stage_end(&ost->encode_time, encode_start);
                 update_benchmark("flush %s %d.%d", desc, ost->file_index, ost->index);
                 if (ret < 0) {
                     av_log(NULL, AV_LOG_FATAL, "%s encoding failed\n", desc);
@@ -1689,6 +1811,12 @@ static void do_streamcopy(InputStream *ist, OutputStream *ost, const AVPacket *p
         opkt.data = (uint8_t *)&pict;
         opkt.size = sizeof(AVPicture);
         opkt.flags |= AV_PKT_FLAG_KEY;
+    } else if (!opkt.buf && pkt->buf) {
+        /* opkt.data still points into the demuxer's packet; take a reference
+         * so the muxer does not have to duplicate the payload */
+        opkt.buf = av_buffer_ref(pkt->buf);
+        if (!opkt.buf)
+            exit_program(1);
     }
 
     write_frame(of->ctx, &opkt, ost);
@@ -1720,6 +1848,7 @@ static int decode_audio(InputStream *ist, AVPacket *pkt, int *got_output)
     AVCodecContext *avctx = ist->dec_ctx;
     int i, ret, err = 0, resample_changed;
     AVRational decoded_frame_tb;
+    int64_t decode_start, filter_start;
 
     if (!ist->decoded_frame && !(ist->decoded_frame = av_frame_alloc()))
         return AVERROR(ENOMEM);
@@ -1728,7 +1857,9 @@ static int decode_audio(InputStream *ist, AVPacket *pkt, int *got_output)
     decoded_frame = ist->decoded_frame;
 
     update_benchmark(NULL);
+    decode_start = stage_start();
     ret = avcodec_decode_audio4(avctx, decoded_frame, got_output, pkt);
+    stage_end(&ist->decode_time, decode_start);
     update_benchmark("decode_audio %d.%d", ist->file_index, ist->st->index);
 
     if (ret >= 0 && avctx->sample_rate <= 0) {
@@ -1842,8 +1973,10 @@ static int decode_audio(InputStream *ist, AVPacket *pkt, int *got_output)
                 break;
         } else
             f = decoded_frame;
+        filter_start = stage_start();
         err = av_buffersrc_add_frame_flags(ist->filters[i]->filter, f,
                                      AV_BUFFERSRC_FLAG_PUSH);
+        stage_end(&ist->filter_time, filter_start);
         if (err == AVERROR_EOF)
             err = 0; /* ignore */
         if (err < 0)
@@ -1861,6 +1994,7 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output)
     AVFrame *decoded_frame, *f;
     int i, ret = 0, err = 0, resample_changed;
     int64_t best_effort_timestamp;
+    int64_t decode_start, filter_start;
     AVRational *frame_sample_aspect;
 
     if (!ist->decoded_frame && !(ist->decoded_frame = av_frame_alloc()))
@@ -1871,8 +2005,10 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output)
     pkt->dts  = av_rescale_q(ist->dts, AV_TIME_BASE_Q, ist->st->time_base);
 
     update_benchmark(NULL);
+    decode_start = stage_start();
     ret = avcodec_decode_video2(ist->dec_ctx,
                                 decoded_frame, got_output, pkt);
+    stage_end(&ist->decode_time, decode_start);
     update_benchmark("decode_video %d.%d", ist->file_index, ist->st->index);
 
     // The following line may be required in some cases where there is no parser
@@ -1971,7 +2107,9 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output)
                 break;
         } else
             f = decoded_frame;
+        filter_start = stage_start();
         ret = av_buffersrc_add_frame_flags(ist->filters[i]->filter, f, AV_BUFFERSRC_FLAG_PUSH);
+        stage_end(&ist->filter_time, filter_start);
         if (ret == AVERROR_EOF) {
             ret = 0; /* ignore */
         } else if (ret < 0) {
@@ -3078,13 +3216,12 @@ static OutputStream *choose_output(void)
 static int check_keyboard_interaction(int64_t cur_time)
 {
     int i, ret, key;
-    static int64_t last_time;
     if (received_nb_signals)
         return AVERROR_EXIT;
     /* read_key() returns 0 on EOF */
-    if(cur_time - last_time >= 100000 && !run_as_daemon){
+    if(cur_time - last_key_time >= 100000 && !run_as_daemon){
         key =  read_key();
-        last_time = cur_time;
+        last_key_time = cur_time;
     }else
         key = -1;
     if (key == 'q')
@@ -3313,9 +3450,12 @@ static int process_input(int file_index)
     InputStream *ist;
     AVPacket pkt;
     int ret, i, j;
+    int64_t demux_start, demux_time = 0;
 
     is  = ifile->ctx;
+    demux_start = stage_start();
     ret = get_input_packet(ifile, &pkt);
+    stage_end(&demux_time, demux_start);
 
     if (ret == AVERROR(EAGAIN)) {
         ifile->eagain = 1;
@@ -3367,6 +3507,7 @@ static int process_input(int file_index)
 
     ist->data_size += pkt.size;
     ist->nb_packets++;
+    ist->demux_time += demux_time;
 
     if (ist->discard)
         goto discard_packet;
@@ -3539,9 +3680,13 @@ static int transcode_from_filter(FilterGraph *graph, InputStream **best_ist)
     int nb_requests, nb_requests_max = 0;
     InputFilter *ifilter;
     InputStream *ist;
+    int64_t filter_start;
 
     *best_ist = NULL;
+    /* graphs with several outputs count this for the first one */
+    filter_start = stage_start();
     ret = avfilter_graph_request_oldest(graph->graph);
+    stage_end(&graph->outputs[0]->ost->filter_time, filter_start);
     if (ret >= 0)
         return reap_filters();
 
@@ -3669,6 +3814,7 @@ static int transcode(void)
 
         /* dump report by using the output first video and audio streams */
         print_report(0, timer_start, cur_time);
+        print_stats_json(0);
     }
 #if HAVE_PTHREADS
     free_input_threads();
@@ -3780,18 +3926,86 @@ static void log_callback_null(void *ptr, int level, const char *fmt, va_list vl)
 {
 }
 
-int main(int argc, char **argv)
+static jmp_buf job_exit_env;
+static int job_running;
+static int job_exit_code;
+
+static void ffmpeg_job_exit(int ret)
+{
+    ffmpeg_cleanup(ret);
+
+    /* exit_program() would terminate the process; return from
+     * ffmpeg_run_job() instead so the caller can run the next job */
+    if (job_running) {
+        job_running   = 0;
+        job_exit_code = ret;
+        longjmp(job_exit_env, 1);
+    }
+}
+
+/* Put the globals that the previous job may have changed back to their
+ * initial values; ffmpeg_cleanup() already freed everything they owned. */
+static void ffmpeg_reset(void)
+{
+    received_sigterm    = 0;
+    received_nb_signals = 0;
+    transcode_init_done = 0;
+    main_return_code    = 0;
+    run_as_daemon       = 0;
+    nb_frames_dup       = 0;
+    nb_frames_drop      = 0;
+    decode_error_stat[0] = decode_error_stat[1] = 0;
+    last_report_time    = -1;
+    last_key_time       = 0;
+    memset(qp_histogram, 0, sizeof(qp_histogram));
+    job_start_time = last_stats_json_time = av_gettime_relative();
+
+    ffmpeg_reset_options();
+    hide_banner = 0;
+
+    /* these live in libavutil and outlast the job; INT_MAX is the
+     * av_max_alloc() default */
+    if (!job_defaults_saved) {
+        default_cpu_flags  = av_get_cpu_flags();
+        job_defaults_saved = 1;
+    }
+    av_force_cpu_flags(default_cpu_flags);
+    av_max_alloc(INT_MAX);
+
+    av_log_set_level(AV_LOG_INFO);
+    av_log_set_callback(av_log_default_callback);
+}
+
+/**
+ * Run one ffmpeg command line to completion. Unlike main(), this returns
+ * the exit code instead of terminating the process, so a host that keeps
+ * the program loaded (e.g. an Emscripten module kept alive between jobs)
+ * can call it repeatedly.
+ */
+int ffmpeg_run_job(int argc, char **argv)
 {
     int ret;
     int64_t ti;
 
-    register_exit(ffmpeg_cleanup);
+    ffmpeg_reset();
+
+    register_exit(ffmpeg_job_exit);
+    job_running = 1;
+    if (setjmp(job_exit_env))
+        return job_exit_code;
 
     setvbuf(stderr,NULL,_IONBF,0); /* win32 runtime needs this */
 
     av_log_set_flags(AV_LOG_SKIP_REPEATED);
     parse_loglevel(argc, argv, options);
 
+    /* the allocation statistics of -stats_json have to be on before the
+     * options are parsed, so that the blocks allocated for them are counted
+     * when they are freed */
+    av_mem_stats_enable(locate_option(argc, argv, options, "stats_json"));
+    av_mem_reset_peak();
+    job_start_allocs = av_mem_nb_allocs();
+
     if(argc>1 && !strcmp(argv[1], "-d")){
         run_as_daemon=1;
         av_log_set_callback(log_callback_null);
@@ -3848,3 +4062,8 @@ int main(int argc, char **argv)
     exit_program(received_nb_signals ? 255 : main_return_code);
     return main_return_code;
 }
+
+int main(int argc, char **argv)
+{
+    return ffmpeg_run_job(argc, argv);
+}
@@ -322,6 +322,10 @@ typedef struct InputStream {
     // number of frames/samples retrieved from the decoder
     uint64_t frames_decoded;
     uint64_t samples_decoded;
+    // time spent in each stage, for -stats_json (in microseconds)
+    int64_t demux_time;
+    int64_t decode_time;
+    int64_t filter_time;
 } InputStream;
 
 typedef struct InputFile {
@@ -437,6 +441,10 @@ typedef struct OutputStream {
     // number of frames/samples sent to the encoder
     uint64_t frames_encoded;
     uint64_t samples_encoded;
+    // time spent in each stage, for -stats_json (in microseconds)
+    int64_t filter_time;
+    int64_t encode_time;
+    int64_t mux_time;
 } OutputStream;
 
 typedef struct OutputFile {
@@ -486,6 +494,8 @@ extern int qp_hist;
 extern int stdin_interaction;
 extern int frame_bits_per_raw_sample;
 extern AVIOContext *progress_avio;
+extern AVIOContext *stats_json_avio;
+extern float stats_json_period;
 extern float max_error_rate;
 
 extern const AVIOInterruptCB int_cb;
@@ -515,6 +525,23 @@ int ist_in_filtergraph(FilterGraph *fg, InputStream *ist);
 FilterGraph *init_simple_filtergraph(InputStream *ist, OutputStream *ost);
 
 int ffmpeg_parse_options(int argc, char **argv);
+void ffmpeg_uninit_parse_options(void);
+void ffmpeg_reset_options(void);
+
+int ffmpeg_run_job(int argc, char **argv);
+
+/**
+ * Decode up to count keyframes spread evenly over the first video stream of
+ * filename and scale them to width x height RGBA, without going through the
+ * filtergraph or an encoder.
+ *
+ * @param dst   receives the pictures back to back, count * width * height * 4
+ *              bytes
+ * @param times receives the time of each picture in seconds from the start
+ * @return the number of pictures written, or a negative AVERROR code
+ */
+int ffmpeg_thumbnails(const char *filename, int count, int width, int height,
+                      uint8_t *dst, double *times);
 
 int vdpau_init(AVCodecContext *s);
 int dxva2_init(AVCodecContext *s);
@@ -99,6 +99,7 @@ int qp_hist           = 0;
 int stdin_interaction = 1;
 int frame_bits_per_raw_sample = 0;
 float max_error_rate  = 2.0/3;
+float stats_json_period = 1.0;
 
 
 static int intra_only         = 0;
@@ -108,6 +109,42 @@ static int do_psnr            = 0;
 static int input_sync;
 static int override_ffserver  = 0;
 
+/* keep in sync with the initializers above */
+void ffmpeg_reset_options(void)
+{
+    av_freep(&vstats_filename);
+
+    audio_drift_threshold = 0.1;
+    dts_delta_threshold   = 10;
+    dts_error_threshold   = 3600*30;
+
+    audio_volume      = 256;
+    audio_sync_method = 0;
+    video_sync_method = VSYNC_AUTO;
+    do_deinterlace    = 0;
+    do_benchmark      = 0;
+    do_benchmark_all  = 0;
+    do_hex_dump       = 0;
+    do_pkt_dump       = 0;
+    copy_ts           = 0;
+    copy_tb           = -1;
+    debug_ts          = 0;
+    exit_on_error     = 0;
+    print_stats       = -1;
+    qp_hist           = 0;
+    stdin_interaction = 1;
+    frame_bits_per_raw_sample = 0;
+    max_error_rate    = 2.0/3;
+    stats_json_period = 1.0;
+
+    intra_only         = 0;
+    file_overwrite     = 0;
+    no_file_overwrite  = 0;
+    do_psnr            = 0;
+    input_sync         = 0;
+    override_ffserver  = 0;
+}
+
 static void uninit_options(OptionsContext *o)
 {
     const OptionDef *po = options;
@@ -2626,6 +2663,13 @@ static const OptionGroupDef groups[] = {
     [GROUP_INFILE]  = { "input file",   "i",  OPT_INPUT },
 };
 
+/* The command line being parsed and the options of the file being opened.
+ * Any error in between can end up in exit_program(), which returns from
+ * ffmpeg_run_job() without coming back here, so ffmpeg_cleanup() frees them
+ * through ffmpeg_uninit_parse_options() in that case. */
+static OptionParseContext parse_octx;
+static OptionsContext *open_file_options;
+
 static int open_files(OptionGroupList *l, const char *inout,
                       int (*open_file)(OptionsContext*, const char*))
 {
@@ -2637,17 +2681,21 @@ static int open_files(OptionGroupList *l, const char *inout,
 
         init_options(&o);
         o.g = g;
+        open_file_options = &o;
 
         ret = parse_optgroup(&o, g);
         if (ret < 0) {
             av_log(NULL, AV_LOG_ERROR, "Error parsing options for %s file "
                    "%s.\n", inout, g->arg);
+            uninit_options(&o);
+            open_file_options = NULL;
             return ret;
         }
 
         av_log(NULL, AV_LOG_DEBUG, "Opening an %s file: %s.\n", inout, g->arg);
         ret = open_file(&o, g->arg);
         uninit_options(&o);
+        open_file_options = NULL;
         if (ret < 0) {
             av_log(NULL, AV_LOG_ERROR, "Error opening %s file %s.\n",
                    inout, g->arg);
@@ -2659,16 +2707,26 @@ static int open_files(OptionGroupList *l, const char *inout,
     return 0;
 }
 
+void ffmpeg_uninit_parse_options(void)
+{
+    if (open_file_options) {
+        uninit_options(open_file_options);
+        open_file_options = NULL;
+    }
+    uninit_parse_context(&parse_octx);
+    memset(&parse_octx, 0, sizeof(parse_octx));
+}
+
 int ffmpeg_parse_options(int argc, char **argv)
 {
-    OptionParseContext octx;
+    OptionParseContext *octx = &parse_octx;
     uint8_t error[128];
     int ret;
 
-    memset(&octx, 0, sizeof(octx));
+    memset(octx, 0, sizeof(*octx));
 
     /* split the commandline into an internal representation */
-    ret = split_commandline(&octx, argc, argv, options, groups,
+    ret = split_commandline(octx, argc, argv, options, groups,
                             FF_ARRAY_ELEMS(groups));
     if (ret < 0) {
         av_log(NULL, AV_LOG_FATAL, "Error splitting the argument list: ");
@@ -2676,28 +2734,28 @@ int ffmpeg_parse_options(int argc, char **argv)
     }
 
     /* apply global options */
-    ret = parse_optgroup(NULL, &octx.global_opts);
+    ret = parse_optgroup(NULL, &octx->global_opts);
     if (ret < 0) {
         av_log(NULL, AV_LOG_FATAL, "Error parsing global options: ");
         goto fail;
     }
 
     /* open input files */
-    ret = open_files(&octx.groups[GROUP_INFILE], "input", open_input_file);
+    ret = open_files(&octx->groups[GROUP_INFILE], "input", open_input_file);
     if (ret < 0) {
         av_log(NULL, AV_LOG_FATAL, "Error opening input files: ");
         goto fail;
     }
 
     /* open output files */
-    ret = open_files(&octx.groups[GROUP_OUTFILE], "output", open_output_file);
+    ret = open_files(&octx->groups[GROUP_OUTFILE], "output", open_output_file);
     if (ret < 0) {
         av_log(NULL, AV_LOG_FATAL, "Error opening output files: ");
         goto fail;
     }
 
 fail:
-    uninit_parse_context(&octx);
+    ffmpeg_uninit_parse_options();
     if (ret < 0) {
         av_strerror(ret, error, sizeof(error));
         av_log(NULL, AV_LOG_FATAL, "%s\n", error);
@@ -2722,6 +2780,24 @@ static int opt_progress(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+static int opt_stats_json(void *optctx, const char *opt, const char *arg)
+{
+    AVIOContext *avio = NULL;
+    int ret;
+
+    if (!strcmp(arg, "-"))
+        arg = "pipe:";
+    ret = avio_open2(&avio, arg, AVIO_FLAG_WRITE, &int_cb, NULL);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to open stats URL \"%s\": %s\n",
+               arg, av_err2str(ret));
+        return ret;
+    }
+    avio_closep(&stats_json_avio);
+    stats_json_avio = avio;
+    return 0;
+}
+
 #define OFFSET(x) offsetof(OptionsContext, x)
 const OptionDef options[] = {
     /* main options */
@@ -2788,6 +2864,10 @@ const OptionDef options[] = {
       "add timings for each task" },
     { "progress",       HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_progress },
       "write program-readable progress information", "url" },
+    { "stats_json",     HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_stats_json },
+      "write per-stream stage timings and memory use as JSON lines", "url" },
+    { "stats_json_period", HAS_ARG | OPT_FLOAT | OPT_EXPERT,         { &stats_json_period },
+      "set the interval of -stats_json reports", "seconds" },
     { "stdin",          OPT_BOOL | OPT_EXPERT,                       { &stdin_interaction },
       "enable or disable interaction on standard input" },
     { "timelimit",      HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_timelimit },
@@ -0,0 +1,167 @@
+/*
+ * ffmpeg keyframe thumbnails
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <math.h>
+
+#include "ffmpeg.h"
+
+#include "libavutil/avutil.h"
+#include "libavutil/frame.h"
+#include "libavutil/mathematics.h"
+#include "libswscale/swscale.h"
+
+/* Decode until a picture newer than min_ts comes out. The decoder is set to
+ * skip everything but keyframes, so the other packets only cost parsing. */
+static int decode_next_keyframe(AVFormatContext *ic, AVCodecContext *dec,
+                                int stream_index, AVFrame *frame, int64_t min_ts)
+{
+    AVPacket pkt;
+    int got_frame, eof = 0;
+
+    for (;;) {
+        int64_t ts;
+
+        if (!eof) {
+            if (av_read_frame(ic, &pkt) < 0)
+                eof = 1;
+            else if (pkt.stream_index != stream_index) {
+                av_free_packet(&pkt);
+                continue;
+            }
+        }
+        if (eof) {
+            /* drain the pictures the decoder is still holding back */
+            av_init_packet(&pkt);
+            pkt.data = NULL;
+            pkt.size = 0;
+        }
+
+        got_frame = 0;
+        avcodec_decode_video2(dec, frame, &got_frame, &pkt);
+        av_free_packet(&pkt);
+        if (!got_frame) {
+            if (eof)
+                return AVERROR_EOF;
+            continue;
+        }
+
+        ts = av_frame_get_best_effort_timestamp(frame);
+        if (ts == AV_NOPTS_VALUE || ts > min_ts)
+            return 0;
+        av_frame_unref(frame);
+    }
+}
+
+int ffmpeg_thumbnails(const char *filename, int count, int width, int height,
+                      uint8_t *dst, double *times)
+{
+    AVFormatContext *ic = NULL;
+    AVCodecContext *dec = NULL;
+    AVCodec *codec = NULL;
+    AVFrame *frame = NULL;
+    struct SwsContext *sws = NULL;
+    AVStream *st;
+    int64_t start, last_ts = INT64_MIN;
+    int i, ret, seekable, nb_thumbnails = 0;
+
+    av_register_all();
+
+    if ((ret = avformat_open_input(&ic, filename, NULL, NULL)) < 0)
+        goto end;
+    if ((ret = avformat_find_stream_info(ic, NULL)) < 0)
+        goto end;
+    if ((ret = av_find_best_stream(ic, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0)) < 0)
+        goto end;
+    st = ic->streams[ret];
+
+    for (i = 0; i < ic->nb_streams; i++)
+        ic->streams[i]->discard = AVDISCARD_ALL;
+    st->discard = AVDISCARD_NONKEY;
+
+    dec = st->codec;
+    dec->skip_frame        = AVDISCARD_NONKEY;
+    dec->skip_loop_filter  = AVDISCARD_ALL;
+    dec->refcounted_frames = 1;
+    if ((ret = avcodec_open2(dec, codec, NULL)) < 0) {
+        dec = NULL;
+        goto end;
+    }
+
+    if (!(frame = av_frame_alloc())) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    start    = ic->start_time != AV_NOPTS_VALUE ? ic->start_time : 0;
+    seekable = ic->duration > 0 && ic->pb && ic->pb->seekable;
+
+    for (i = 0; i < count; i++) {
+        /* the middle of the i-th of count equal parts of the file */
+        int64_t target = ic->duration > 0 ?
+                         start + av_rescale(ic->duration, 2 * i + 1, 2 * count) : start;
+        int64_t min_ts = last_ts, ts;
+        uint8_t *dst_data[4]     = { dst + (size_t)nb_thumbnails * width * height * 4 };
+        int      dst_linesize[4] = { width * 4 };
+
+        /* The seek lands on the keyframe at or before the target. If that is
+         * the previous thumbnail again, decoding continues to the next one.
+         * Without seeking, the keyframes before the target are skipped. */
+        if (seekable && avformat_seek_file(ic, -1, INT64_MIN, target, target, 0) >= 0)
+            avcodec_flush_buffers(dec);
+        else if (ic->duration > 0)
+            min_ts = FFMAX(min_ts, av_rescale_q(target, AV_TIME_BASE_Q, st->time_base) - 1);
+
+        if ((ret = decode_next_keyframe(ic, dec, st->index, frame, min_ts)) < 0)
+            break;
+
+        /* RGBA is written straight from the scaled lines, there is no
+         * intermediate picture in the source format */
+        sws = sws_getCachedContext(sws, frame->width, frame->height, frame->format,
+                                   width, height, AV_PIX_FMT_RGBA,
+                                   SWS_BILINEAR, NULL, NULL, NULL);
+        if (!sws) {
+            ret = AVERROR(EINVAL);
+            break;
+        }
+        sws_scale(sws, (const uint8_t * const *)frame->data, frame->linesize,
+                  0, frame->height, dst_data, dst_linesize);
+
+        ts = av_frame_get_best_effort_timestamp(frame);
+        if (ts != AV_NOPTS_VALUE) {
+            times[nb_thumbnails] = ts * av_q2d(st->time_base) - start / (double)AV_TIME_BASE;
+            last_ts = ts;
+        } else
+            times[nb_thumbnails] = NAN;
+        nb_thumbnails++;
+        av_frame_unref(frame);
+    }
+
+end:
+    if (ret < 0 && ret != AVERROR_EOF)
+        av_log(NULL, AV_LOG_ERROR, "%s: could not extract thumbnails: %s\n",
+               filename, av_err2str(ret));
+    av_frame_free(&frame);
+    sws_freeContext(sws);
+    if (dec)
+        avcodec_close(dec);
+    avformat_close_input(&ic);
+
+    return nb_thumbnails || ret == AVERROR_EOF || ret >= 0 ? nb_thumbnails : ret;
+}
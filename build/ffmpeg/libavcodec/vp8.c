@@ -61,6 +61,7 @@ static void free_buffers(VP8Context *s)
     av_freep(&s->intra4x4_pred_mode_top);
     av_freep(&s->top_nnz);
     av_freep(&s->top_border);
+    av_buffer_pool_uninit(&s->seg_map_pool);
 
     s->macroblocks = NULL;
 }
@@ -71,10 +72,16 @@ static int vp8_alloc_frame(VP8Context *s, VP8Frame *f, int ref)
     if ((ret = ff_thread_get_buffer(s->avctx, &f->tf,
                                     ref ? AV_GET_BUFFER_FLAG_REF : 0)) < 0)
         return ret;
-    if (!(f->seg_map = av_buffer_allocz(s->mb_width * s->mb_height))) {
+    if (!s->seg_map_pool)
+        s->seg_map_pool = av_buffer_pool_init(s->mb_width * s->mb_height,
+                                              av_buffer_allocz);
+    if (!s->seg_map_pool ||
+        !(f->seg_map = av_buffer_pool_get(s->seg_map_pool))) {
         ff_thread_release_buffer(s->avctx, &f->tf);
         return AVERROR(ENOMEM);
     }
+    /* without a previous map, segment ids that are not coded stay 0 */
+    memset(f->seg_map->data, 0, f->seg_map->size);
     return 0;
 }
 
@@ -243,6 +243,7 @@ typedef struct VP8Context {
     } prob[2];
 
     VP8Macroblock *macroblocks_base;
+    AVBufferPool *seg_map_pool; ///< segmentation maps, one per frame
     int invisible;
     int update_last;    ///< update VP56_FRAME_PREVIOUS with the current one
     int update_golden;  ///< VP56_FRAME_NONE if not updated, or which frame to copy if so
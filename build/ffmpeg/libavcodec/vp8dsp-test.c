@@ -0,0 +1,158 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Compare the optimized VP8 DSP functions selected for this CPU against
+ * the C reference, which must be matched bit for bit.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/cpu.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "vp8dsp.h"
+
+#define SRC_STRIDE 64
+#define DST_STRIDE 32
+#define ITERATIONS 64
+
+static AVLFG prng;
+
+static void randomize(uint8_t *buf, int size)
+{
+    int i;
+    for (i = 0; i < size; i++)
+        buf[i] = av_lfg_get(&prng);
+}
+
+/* first table index selects width, the other two the 0/4/6-tap filters */
+static int pick_subpel(int taps)
+{
+    static const int odd[]  = { 1, 3, 5, 7 };
+    static const int even[] = { 2, 4, 6 };
+
+    if (!taps)
+        return 0;
+    return taps == 1 ? odd[av_lfg_get(&prng) % 4] : even[av_lfg_get(&prng) % 3];
+}
+
+static int check_mc(const char *name, vp8_mc_func ref_tab[3][3][3],
+                    vp8_mc_func opt_tab[3][3][3])
+{
+    LOCAL_ALIGNED_16(uint8_t, src, [SRC_STRIDE * 32]);
+    LOCAL_ALIGNED_16(uint8_t, dst_ref, [DST_STRIDE * 16]);
+    LOCAL_ALIGNED_16(uint8_t, dst_opt, [DST_STRIDE * 16]);
+    int w, v, hz, n, ret = 0;
+
+    for (w = 0; w < 3; w++)
+        for (v = 0; v < 3; v++)
+            for (hz = 0; hz < 3; hz++) {
+                int size = 16 >> w;
+
+                if (ref_tab[w][v][hz] == opt_tab[w][v][hz])
+                    continue;
+
+                for (n = 0; n < ITERATIONS; n++) {
+                    int h  = n & 1 ? size : size >> 1;
+                    int mx = pick_subpel(hz), my = pick_subpel(v);
+                    uint8_t *s = src + 8 * SRC_STRIDE + 8;
+
+                    randomize(src, SRC_STRIDE * 32);
+                    randomize(dst_ref, DST_STRIDE * 16);
+                    memcpy(dst_opt, dst_ref, DST_STRIDE * 16);
+
+                    ref_tab[w][v][hz](dst_ref, DST_STRIDE, s, SRC_STRIDE,
+                                      h, mx, my);
+                    opt_tab[w][v][hz](dst_opt, DST_STRIDE, s, SRC_STRIDE,
+                                      h, mx, my);
+                    if (memcmp(dst_ref, dst_opt, DST_STRIDE * 16)) {
+                        fprintf(stderr, "%s[%d][%d][%d] mismatch, "
+                                "h=%d mx=%d my=%d\n", name, w, v, hz, h, mx, my);
+                        ret = 1;
+                        break;
+                    }
+                }
+            }
+
+    return ret;
+}
+
+static int check_idct_dc_add4(const char *name,
+                              void (*ref)(uint8_t *, int16_t[4][16], ptrdiff_t),
+                              void (*opt)(uint8_t *, int16_t[4][16], ptrdiff_t))
+{
+    LOCAL_ALIGNED_16(uint8_t, dst_ref, [DST_STRIDE * 8]);
+    LOCAL_ALIGNED_16(uint8_t, dst_opt, [DST_STRIDE * 8]);
+    LOCAL_ALIGNED_16(int16_t, block_ref, [4], [16]);
+    LOCAL_ALIGNED_16(int16_t, block_opt, [4], [16]);
+    int i, n;
+
+    if (ref == opt)
+        return 0;
+
+    for (n = 0; n < ITERATIONS; n++) {
+        randomize(dst_ref, DST_STRIDE * 8);
+        memcpy(dst_opt, dst_ref, DST_STRIDE * 8);
+        memset(block_ref, 0, sizeof(int16_t) * 4 * 16);
+        for (i = 0; i < 4; i++)
+            block_ref[i][0] = (int16_t)av_lfg_get(&prng);
+        memcpy(block_opt, block_ref, sizeof(int16_t) * 4 * 16);
+
+        ref(dst_ref, block_ref, DST_STRIDE);
+        opt(dst_opt, block_opt, DST_STRIDE);
+        if (memcmp(dst_ref, dst_opt, DST_STRIDE * 8) ||
+            memcmp(block_ref, block_opt, sizeof(int16_t) * 4 * 16)) {
+            fprintf(stderr, "%s mismatch\n", name);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    VP8DSPContext ref, opt;
+    int ret = 0;
+
+    av_lfg_init(&prng, 0xdeadbeef);
+
+    av_force_cpu_flags(0);
+    ff_vp78dsp_init(&ref);
+    ff_vp8dsp_init(&ref);
+
+    av_force_cpu_flags(-1);
+    ff_vp78dsp_init(&opt);
+    ff_vp8dsp_init(&opt);
+
+    ret |= check_mc("put_vp8_epel_pixels_tab", ref.put_vp8_epel_pixels_tab,
+                    opt.put_vp8_epel_pixels_tab);
+    ret |= check_mc("put_vp8_bilinear_pixels_tab",
+                    ref.put_vp8_bilinear_pixels_tab,
+                    opt.put_vp8_bilinear_pixels_tab);
+    ret |= check_idct_dc_add4("vp8_idct_dc_add4y", ref.vp8_idct_dc_add4y,
+                              opt.vp8_idct_dc_add4y);
+    ret |= check_idct_dc_add4("vp8_idct_dc_add4uv", ref.vp8_idct_dc_add4uv,
+                              opt.vp8_idct_dc_add4uv);
+
+    return ret;
+}
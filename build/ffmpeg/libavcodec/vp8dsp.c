@@ -675,6 +675,8 @@ av_cold void ff_vp78dsp_init(VP8DSPContext *dsp)
         ff_vp78dsp_init_arm(dsp);
     if (ARCH_PPC)
         ff_vp78dsp_init_ppc(dsp);
+    if (ARCH_WASM)
+        ff_vp78dsp_init_wasm(dsp);
     if (ARCH_X86)
         ff_vp78dsp_init_x86(dsp);
 }
@@ -733,6 +735,8 @@ av_cold void ff_vp8dsp_init(VP8DSPContext *dsp)
 
     if (ARCH_ARM)
         ff_vp8dsp_init_arm(dsp);
+    if (ARCH_WASM)
+        ff_vp8dsp_init_wasm(dsp);
     if (ARCH_X86)
         ff_vp8dsp_init_x86(dsp);
 }
@@ -93,10 +93,12 @@ void ff_vp7dsp_init(VP8DSPContext *c);
 void ff_vp78dsp_init(VP8DSPContext *c);
 void ff_vp78dsp_init_arm(VP8DSPContext *c);
 void ff_vp78dsp_init_ppc(VP8DSPContext *c);
+void ff_vp78dsp_init_wasm(VP8DSPContext *c);
 void ff_vp78dsp_init_x86(VP8DSPContext *c);
 
 void ff_vp8dsp_init(VP8DSPContext *c);
 void ff_vp8dsp_init_arm(VP8DSPContext *c);
+void ff_vp8dsp_init_wasm(VP8DSPContext *c);
 void ff_vp8dsp_init_x86(VP8DSPContext *c);
 
 #define IS_VP7 1
@@ -239,6 +239,7 @@ typedef struct VP9Context {
     // whole-frame cache
     uint8_t *intra_pred_data[3];
     struct VP9Filter *lflvl;
+    AVBufferPool *extradata_pool; // segmentation map and mvs of each frame
     DECLARE_ALIGNED(32, uint8_t, edge_emu_buffer)[71*80];
 
     // block reconstruction intermediates
@@ -268,10 +269,15 @@ static int vp9_alloc_frame(AVCodecContext *ctx, VP9Frame *f)
     if ((ret = ff_thread_get_buffer(ctx, &f->tf, AV_GET_BUFFER_FLAG_REF)) < 0)
         return ret;
     sz = 64 * s->sb_cols * s->sb_rows;
-    if (!(f->extradata = av_buffer_allocz(sz * (1 + sizeof(struct VP9mvrefPair))))) {
+    if (!s->extradata_pool)
+        s->extradata_pool = av_buffer_pool_init(sz * (1 + sizeof(struct VP9mvrefPair)),
+                                                av_buffer_allocz);
+    if (!s->extradata_pool ||
+        !(f->extradata = av_buffer_pool_get(s->extradata_pool))) {
         ff_thread_release_buffer(ctx, &f->tf);
         return AVERROR(ENOMEM);
     }
+    memset(f->extradata->data, 0, f->extradata->size);
 
     f->segmentation_map = f->extradata->data;
     f->mv = (struct VP9mvrefPair *) (f->extradata->data + sz);
@@ -352,6 +358,7 @@ static int update_size(AVCodecContext *ctx, int w, int h)
     // these will be re-allocated a little later
     av_freep(&s->b_base);
     av_freep(&s->block_base);
+    av_buffer_pool_uninit(&s->extradata_pool);
 
     return 0;
 }
@@ -3698,6 +3705,7 @@ static void free_buffers(VP9Context *s)
     av_freep(&s->intra_pred_data[0]);
     av_freep(&s->b_base);
     av_freep(&s->block_base);
+    av_buffer_pool_uninit(&s->extradata_pool);
 }
 
 static av_cold int vp9_decode_free(AVCodecContext *ctx)
@@ -0,0 +1,174 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Compare the optimized VP9 inverse transforms and loop filters selected
+ * for this CPU against the C reference, which must be matched bit for bit.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/cpu.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "vp9dsp.h"
+
+#define STRIDE     64
+#define ITERATIONS 256
+
+static AVLFG prng;
+
+static void randomize(uint8_t *buf, int size)
+{
+    int i;
+    for (i = 0; i < size; i++)
+        buf[i] = av_lfg_get(&prng);
+}
+
+/* Mostly small coefficients as in real streams, with the occasional block
+ * of full range ones to cover the 16-bit wrap-around of the C version. */
+static int check_itxfm(VP9DSPContext *ref, VP9DSPContext *opt)
+{
+    LOCAL_ALIGNED_16(uint8_t, dst_ref, [STRIDE * 32]);
+    LOCAL_ALIGNED_16(uint8_t, dst_opt, [STRIDE * 32]);
+    LOCAL_ALIGNED_16(int16_t, block_ref, [32 * 32]);
+    LOCAL_ALIGNED_16(int16_t, block_opt, [32 * 32]);
+    int tx, type, n, i;
+
+    for (tx = 0; tx <= N_TXFM_SIZES; tx++)
+        for (type = 0; type < N_TXFM_TYPES; type++) {
+            int sz = tx == N_TXFM_SIZES ? 4 : 4 << tx;
+
+            if (ref->itxfm_add[tx][type] == opt->itxfm_add[tx][type])
+                continue;
+
+            for (n = 0; n < ITERATIONS; n++) {
+                int eob = n & 3 ? 1 + av_lfg_get(&prng) % (sz * sz) : 1;
+                int range = n % 16 == 15 ? 65536 : 512;
+
+                memset(block_ref, 0, sizeof(int16_t) * sz * sz);
+                for (i = 0; i < (eob == 1 ? 1 : sz * sz); i++)
+                    block_ref[i] = (int)(av_lfg_get(&prng) % range) - range / 2;
+                memcpy(block_opt, block_ref, sizeof(int16_t) * sz * sz);
+                randomize(dst_ref, STRIDE * 32);
+                memcpy(dst_opt, dst_ref, STRIDE * 32);
+
+                ref->itxfm_add[tx][type](dst_ref, STRIDE, block_ref, eob);
+                opt->itxfm_add[tx][type](dst_opt, STRIDE, block_opt, eob);
+                if (memcmp(dst_ref, dst_opt, STRIDE * 32) ||
+                    memcmp(block_ref, block_opt, sizeof(int16_t) * sz * sz)) {
+                    fprintf(stderr, "itxfm_add[%d][%d] mismatch, eob=%d\n",
+                            tx, type, eob);
+                    return 1;
+                }
+            }
+        }
+
+    return 0;
+}
+
+/* Pixels are a random walk around a random level, so that every mix of
+ * the fm, flat8in, flat8out and hev decisions is hit. */
+static void randomize_edge(uint8_t *buf, int size)
+{
+    int i, v = av_lfg_get(&prng) & 0xff, step = 1 + av_lfg_get(&prng) % 4;
+
+    for (i = 0; i < size; i++) {
+        if (!(av_lfg_get(&prng) & 63))
+            v = av_lfg_get(&prng) & 0xff;
+        v = av_clip_uint8(v + (int)(av_lfg_get(&prng) % (2 * step + 1)) - step);
+        buf[i] = v;
+    }
+}
+
+static int check_lf(const char *name,
+                    void (*ref)(uint8_t *, ptrdiff_t, int, int, int),
+                    void (*opt)(uint8_t *, ptrdiff_t, int, int, int),
+                    int mix)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf_ref, [STRIDE * 32]);
+    LOCAL_ALIGNED_16(uint8_t, buf_opt, [STRIDE * 32]);
+    int n;
+
+    if (ref == opt)
+        return 0;
+
+    for (n = 0; n < ITERATIONS; n++) {
+        int E = av_lfg_get(&prng) % 64, I = av_lfg_get(&prng) % 64;
+        int H = av_lfg_get(&prng) % 16;
+
+        if (mix) {
+            E |= (av_lfg_get(&prng) % 64) << 8;
+            I |= (av_lfg_get(&prng) % 64) << 8;
+            H |= (av_lfg_get(&prng) % 16) << 8;
+        }
+        randomize_edge(buf_ref, STRIDE * 32);
+        memcpy(buf_opt, buf_ref, STRIDE * 32);
+
+        ref(buf_ref + 8 * STRIDE + 16, STRIDE, E, I, H);
+        opt(buf_opt + 8 * STRIDE + 16, STRIDE, E, I, H);
+        if (memcmp(buf_ref, buf_opt, STRIDE * 32)) {
+            fprintf(stderr, "%s mismatch, E=%x I=%x H=%x\n", name, E, I, H);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    static const char *const dir[2] = { "h", "v" };
+    VP9DSPContext ref, opt;
+    char name[64];
+    int ret = 0, i, j, k;
+
+    av_lfg_init(&prng, 0xdeadbeef);
+
+    av_force_cpu_flags(0);
+    ff_vp9dsp_init(&ref);
+
+    av_force_cpu_flags(-1);
+    ff_vp9dsp_init(&opt);
+
+    ret |= check_itxfm(&ref, &opt);
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 2; j++) {
+            snprintf(name, sizeof(name), "loop_filter_8[%d][%s]", i, dir[j]);
+            ret |= check_lf(name, ref.loop_filter_8[i][j],
+                            opt.loop_filter_8[i][j], 0);
+        }
+    for (j = 0; j < 2; j++) {
+        snprintf(name, sizeof(name), "loop_filter_16[%s]", dir[j]);
+        ret |= check_lf(name, ref.loop_filter_16[j], opt.loop_filter_16[j], 0);
+    }
+    for (i = 0; i < 2; i++)
+        for (j = 0; j < 2; j++)
+            for (k = 0; k < 2; k++) {
+                snprintf(name, sizeof(name), "loop_filter_mix2[%d][%d][%s]",
+                         i, j, dir[k]);
+                ret |= check_lf(name, ref.loop_filter_mix2[i][j][k],
+                                opt.loop_filter_mix2[i][j][k], 1);
+            }
+
+    return ret;
+}
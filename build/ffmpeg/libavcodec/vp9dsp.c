@@ -2061,4 +2061,5 @@ av_cold void ff_vp9dsp_init(VP9DSPContext *dsp)
     vp9dsp_mc_init(dsp);
 
     if (ARCH_X86) ff_vp9dsp_init_x86(dsp);
+    if (ARCH_WASM) ff_vp9dsp_init_wasm(dsp);
 }
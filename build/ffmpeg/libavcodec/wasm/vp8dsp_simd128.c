@@ -0,0 +1,231 @@
+/*
+ * VP8 DSP functions, WebAssembly SIMD128 optimized
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/wasm/cpu.h"
+#include "libavcodec/vp8dsp.h"
+
+#if HAVE_SIMD128
+#include <wasm_simd128.h>
+
+static const uint8_t subpel_filters[7][6] = {
+    { 0,  6, 123,  12,  1, 0 },
+    { 2, 11, 108,  36,  8, 1 },
+    { 0,  9,  93,  50,  6, 0 },
+    { 3, 16,  77,  77, 16, 3 },
+    { 0,  6,  50,  93,  9, 0 },
+    { 1,  8,  36, 108, 11, 2 },
+    { 0,  1,  12, 123,  6, 0 },
+};
+
+/* The positive taps sum to at most 160, so 160 * 255 + 64 still fits an
+ * unsigned 16-bit lane. Subtracting the negative taps with unsigned
+ * saturation clamps below zero exactly like the C crop table does, and the
+ * final signed->unsigned narrowing clamps above 255. The result is therefore
+ * bit-exact with FILTER_6TAP/FILTER_4TAP in vp8dsp.c. */
+static av_always_inline v128_t filter_8px(const uint8_t *src, ptrdiff_t step,
+                                          const uint8_t *F, int is6tap)
+{
+    v128_t pos, neg;
+
+    pos = wasm_i16x8_add(wasm_i16x8_mul(wasm_u16x8_load8x8(src),
+                                        wasm_i16x8_splat(F[2])),
+                         wasm_i16x8_mul(wasm_u16x8_load8x8(src + step),
+                                        wasm_i16x8_splat(F[3])));
+    neg = wasm_i16x8_add(wasm_i16x8_mul(wasm_u16x8_load8x8(src - step),
+                                        wasm_i16x8_splat(F[1])),
+                         wasm_i16x8_mul(wasm_u16x8_load8x8(src + 2 * step),
+                                        wasm_i16x8_splat(F[4])));
+    if (is6tap) {
+        pos = wasm_i16x8_add(pos,
+                             wasm_i16x8_mul(wasm_u16x8_load8x8(src - 2 * step),
+                                            wasm_i16x8_splat(F[0])));
+        pos = wasm_i16x8_add(pos,
+                             wasm_i16x8_mul(wasm_u16x8_load8x8(src + 3 * step),
+                                            wasm_i16x8_splat(F[5])));
+    }
+    pos = wasm_i16x8_add(pos, wasm_i16x8_splat(64));
+
+    return wasm_u16x8_shr(wasm_u16x8_sub_sat(pos, neg), 7);
+}
+
+static av_always_inline
+void put_vp8_epel_simd128_core(uint8_t *dst, ptrdiff_t dst_stride,
+                               uint8_t *src, ptrdiff_t src_stride,
+                               int h, int mxy, int w, int is6tap,
+                               ptrdiff_t step)
+{
+    const uint8_t *filter = subpel_filters[mxy - 1];
+    int y;
+
+    for (y = 0; y < h; y++) {
+        v128_t lo = filter_8px(src, step, filter, is6tap);
+
+        if (w == 16) {
+            v128_t hi = filter_8px(src + 8, step, filter, is6tap);
+            wasm_v128_store(dst, wasm_u8x16_narrow_i16x8(lo, hi));
+        } else {
+            wasm_v128_store64_lane(dst, wasm_u8x16_narrow_i16x8(lo, lo), 0);
+        }
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
+
+#define EPEL_FUNCS(WIDTH, TAPS)                                               \
+static void put_vp8_epel ## WIDTH ## _h ## TAPS ## _simd128(uint8_t *dst,     \
+                                                            ptrdiff_t dstride, \
+                                                            uint8_t *src,     \
+                                                            ptrdiff_t sstride, \
+                                                            int h, int mx,    \
+                                                            int my)           \
+{                                                                             \
+    put_vp8_epel_simd128_core(dst, dstride, src, sstride, h, mx,              \
+                              WIDTH, TAPS == 6, 1);                           \
+}                                                                             \
+                                                                              \
+static void put_vp8_epel ## WIDTH ## _v ## TAPS ## _simd128(uint8_t *dst,     \
+                                                            ptrdiff_t dstride, \
+                                                            uint8_t *src,     \
+                                                            ptrdiff_t sstride, \
+                                                            int h, int mx,    \
+                                                            int my)           \
+{                                                                             \
+    put_vp8_epel_simd128_core(dst, dstride, src, sstride, h, my,              \
+                              WIDTH, TAPS == 6, sstride);                     \
+}
+
+#define EPEL_HV(WIDTH, HTAPS, VTAPS)                                          \
+static void put_vp8_epel ## WIDTH ## _h ## HTAPS ## v ## VTAPS ## _simd128(   \
+    uint8_t *dst, ptrdiff_t dstride, uint8_t *src, ptrdiff_t sstride,         \
+    int h, int mx, int my)                                                    \
+{                                                                             \
+    DECLARE_ALIGNED(16, uint8_t, tmp)[(2 * WIDTH + 5) * 16];                  \
+    if (VTAPS == 6) {                                                         \
+        put_vp8_epel ## WIDTH ## _h ## HTAPS ## _simd128(tmp, 16,             \
+                                                         src - 2 * sstride,   \
+                                                         sstride, h + 5,      \
+                                                         mx, my);             \
+        put_vp8_epel ## WIDTH ## _v ## VTAPS ## _simd128(dst, dstride,        \
+                                                         tmp + 2 * 16, 16,    \
+                                                         h, mx, my);          \
+    } else {                                                                  \
+        put_vp8_epel ## WIDTH ## _h ## HTAPS ## _simd128(tmp, 16,             \
+                                                         src - sstride,       \
+                                                         sstride, h + 3,      \
+                                                         mx, my);             \
+        put_vp8_epel ## WIDTH ## _v ## VTAPS ## _simd128(dst, dstride,        \
+                                                         tmp + 16, 16,        \
+                                                         h, mx, my);          \
+    }                                                                         \
+}
+
+EPEL_FUNCS(16, 6)
+EPEL_FUNCS(16, 4)
+EPEL_FUNCS(8,  6)
+EPEL_FUNCS(8,  4)
+
+EPEL_HV(16, 6, 6)
+EPEL_HV(16, 4, 6)
+EPEL_HV(16, 6, 4)
+EPEL_HV(16, 4, 4)
+EPEL_HV(8,  6, 6)
+EPEL_HV(8,  4, 6)
+EPEL_HV(8,  6, 4)
+EPEL_HV(8,  4, 4)
+
+static void vp8_idct_dc_add4y_simd128(uint8_t *dst, int16_t block[4][16],
+                                      ptrdiff_t stride)
+{
+    int dc0 = (block[0][0] + 4) >> 3, dc1 = (block[1][0] + 4) >> 3;
+    int dc2 = (block[2][0] + 4) >> 3, dc3 = (block[3][0] + 4) >> 3;
+    v128_t dc_lo = wasm_i16x8_make(dc0, dc0, dc0, dc0, dc1, dc1, dc1, dc1);
+    v128_t dc_hi = wasm_i16x8_make(dc2, dc2, dc2, dc2, dc3, dc3, dc3, dc3);
+    int i;
+
+    block[0][0] = block[1][0] = block[2][0] = block[3][0] = 0;
+
+    for (i = 0; i < 4; i++) {
+        v128_t lo = wasm_i16x8_add(wasm_u16x8_load8x8(dst),     dc_lo);
+        v128_t hi = wasm_i16x8_add(wasm_u16x8_load8x8(dst + 8), dc_hi);
+        wasm_v128_store(dst, wasm_u8x16_narrow_i16x8(lo, hi));
+        dst += stride;
+    }
+}
+
+static void vp8_idct_dc_add4uv_simd128(uint8_t *dst, int16_t block[4][16],
+                                       ptrdiff_t stride)
+{
+    int dc0 = (block[0][0] + 4) >> 3, dc1 = (block[1][0] + 4) >> 3;
+    int dc2 = (block[2][0] + 4) >> 3, dc3 = (block[3][0] + 4) >> 3;
+    v128_t dc_top = wasm_i16x8_make(dc0, dc0, dc0, dc0, dc1, dc1, dc1, dc1);
+    v128_t dc_bot = wasm_i16x8_make(dc2, dc2, dc2, dc2, dc3, dc3, dc3, dc3);
+    int i;
+
+    block[0][0] = block[1][0] = block[2][0] = block[3][0] = 0;
+
+    for (i = 0; i < 8; i++) {
+        v128_t v = wasm_i16x8_add(wasm_u16x8_load8x8(dst), i < 4 ? dc_top
+                                                                : dc_bot);
+        wasm_v128_store64_lane(dst, wasm_u8x16_narrow_i16x8(v, v), 0);
+        dst += stride;
+    }
+}
+#endif /* HAVE_SIMD128 */
+
+av_cold void ff_vp78dsp_init_wasm(VP8DSPContext *c)
+{
+#if HAVE_SIMD128
+    if (!have_simd128(av_get_cpu_flags()))
+        return;
+
+    c->put_vp8_epel_pixels_tab[0][0][1] = put_vp8_epel16_h4_simd128;
+    c->put_vp8_epel_pixels_tab[0][0][2] = put_vp8_epel16_h6_simd128;
+    c->put_vp8_epel_pixels_tab[0][1][0] = put_vp8_epel16_v4_simd128;
+    c->put_vp8_epel_pixels_tab[0][2][0] = put_vp8_epel16_v6_simd128;
+    c->put_vp8_epel_pixels_tab[0][1][1] = put_vp8_epel16_h4v4_simd128;
+    c->put_vp8_epel_pixels_tab[0][1][2] = put_vp8_epel16_h6v4_simd128;
+    c->put_vp8_epel_pixels_tab[0][2][1] = put_vp8_epel16_h4v6_simd128;
+    c->put_vp8_epel_pixels_tab[0][2][2] = put_vp8_epel16_h6v6_simd128;
+
+    c->put_vp8_epel_pixels_tab[1][0][1] = put_vp8_epel8_h4_simd128;
+    c->put_vp8_epel_pixels_tab[1][0][2] = put_vp8_epel8_h6_simd128;
+    c->put_vp8_epel_pixels_tab[1][1][0] = put_vp8_epel8_v4_simd128;
+    c->put_vp8_epel_pixels_tab[1][2][0] = put_vp8_epel8_v6_simd128;
+    c->put_vp8_epel_pixels_tab[1][1][1] = put_vp8_epel8_h4v4_simd128;
+    c->put_vp8_epel_pixels_tab[1][1][2] = put_vp8_epel8_h6v4_simd128;
+    c->put_vp8_epel_pixels_tab[1][2][1] = put_vp8_epel8_h4v6_simd128;
+    c->put_vp8_epel_pixels_tab[1][2][2] = put_vp8_epel8_h6v6_simd128;
+#endif /* HAVE_SIMD128 */
+}
+
+av_cold void ff_vp8dsp_init_wasm(VP8DSPContext *c)
+{
+#if HAVE_SIMD128
+    if (!have_simd128(av_get_cpu_flags()))
+        return;
+
+    c->vp8_idct_dc_add4y  = vp8_idct_dc_add4y_simd128;
+    c->vp8_idct_dc_add4uv = vp8_idct_dc_add4uv_simd128;
+#endif /* HAVE_SIMD128 */
+}
@@ -0,0 +1,641 @@
+/*
+ * VP9 DSP functions, WebAssembly SIMD128 optimized
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/wasm/cpu.h"
+#include "libavcodec/vp9dsp.h"
+
+#if HAVE_SIMD128
+#include <wasm_simd128.h>
+
+/* Inverse transforms.
+ *
+ * Four columns are transformed at once, one per 32-bit lane, so every
+ * intermediate has the same int precision as idct*_1d/iadst*_1d in
+ * vp9dsp.c. Both passes store int16_t in the C version, which is mirrored
+ * by wrapping the lanes to 16 bits, so the output is bit-exact even for
+ * coefficients that overflow. */
+
+#define ADD(a, b) wasm_i32x4_add(a, b)
+#define SUB(a, b) wasm_i32x4_sub(a, b)
+
+static av_always_inline v128_t mulc(v128_t a, int c)
+{
+    return wasm_i32x4_mul(a, wasm_i32x4_splat(c));
+}
+
+static av_always_inline v128_t rnd14(v128_t a)
+{
+    return wasm_i32x4_shr(wasm_i32x4_add(a, wasm_i32x4_splat(1 << 13)), 14);
+}
+
+static av_always_inline v128_t wrap16(v128_t a)
+{
+    return wasm_i32x4_shr(wasm_i32x4_shl(a, 16), 16);
+}
+
+static av_always_inline void idct4_simd128(v128_t *io)
+{
+    v128_t t0, t1, t2, t3;
+
+    t0 = rnd14(mulc(ADD(io[0], io[2]), 11585));
+    t1 = rnd14(mulc(SUB(io[0], io[2]), 11585));
+    t2 = rnd14(SUB(mulc(io[1],  6270), mulc(io[3], 15137)));
+    t3 = rnd14(ADD(mulc(io[1], 15137), mulc(io[3],  6270)));
+
+    io[0] = ADD(t0, t3);
+    io[1] = ADD(t1, t2);
+    io[2] = SUB(t1, t2);
+    io[3] = SUB(t0, t3);
+}
+
+static av_always_inline void iadst4_simd128(v128_t *io)
+{
+    v128_t t0, t1, t2, t3;
+
+    t0 = ADD(ADD(mulc(io[0],  5283), mulc(io[2], 15212)), mulc(io[3],  9929));
+    t1 = SUB(SUB(mulc(io[0],  9929), mulc(io[2],  5283)), mulc(io[3], 15212));
+    t2 = mulc(ADD(SUB(io[0], io[2]), io[3]), 13377);
+    t3 = mulc(io[1], 13377);
+
+    io[0] = rnd14(ADD(t0, t3));
+    io[1] = rnd14(ADD(t1, t3));
+    io[2] = rnd14(t2);
+    io[3] = rnd14(SUB(ADD(t0, t1), t3));
+}
+
+static av_always_inline void idct8_simd128(v128_t *io)
+{
+    v128_t t0, t1, t2, t3, t4, t5, t6, t7;
+    v128_t t0a, t1a, t2a, t3a, t4a, t5a, t6a, t7a;
+
+    t0a = rnd14(mulc(ADD(io[0], io[4]), 11585));
+    t1a = rnd14(mulc(SUB(io[0], io[4]), 11585));
+    t2a = rnd14(SUB(mulc(io[2],  6270), mulc(io[6], 15137)));
+    t3a = rnd14(ADD(mulc(io[2], 15137), mulc(io[6],  6270)));
+    t4a = rnd14(SUB(mulc(io[1],  3196), mulc(io[7], 16069)));
+    t5a = rnd14(SUB(mulc(io[5], 13623), mulc(io[3],  9102)));
+    t6a = rnd14(ADD(mulc(io[5],  9102), mulc(io[3], 13623)));
+    t7a = rnd14(ADD(mulc(io[1], 16069), mulc(io[7],  3196)));
+
+    t0  = ADD(t0a, t3a);
+    t1  = ADD(t1a, t2a);
+    t2  = SUB(t1a, t2a);
+    t3  = SUB(t0a, t3a);
+    t4  = ADD(t4a, t5a);
+    t5a = SUB(t4a, t5a);
+    t7  = ADD(t7a, t6a);
+    t6a = SUB(t7a, t6a);
+
+    t5  = rnd14(mulc(SUB(t6a, t5a), 11585));
+    t6  = rnd14(mulc(ADD(t6a, t5a), 11585));
+
+    io[0] = ADD(t0, t7);
+    io[1] = ADD(t1, t6);
+    io[2] = ADD(t2, t5);
+    io[3] = ADD(t3, t4);
+    io[4] = SUB(t3, t4);
+    io[5] = SUB(t2, t5);
+    io[6] = SUB(t1, t6);
+    io[7] = SUB(t0, t7);
+}
+
+static av_always_inline void iadst8_simd128(v128_t *io)
+{
+    v128_t zero = wasm_i32x4_splat(0);
+    v128_t t0, t1, t2, t3, t4, t5, t6, t7;
+    v128_t t0a, t1a, t2a, t3a, t4a, t5a, t6a, t7a;
+
+    t0a = ADD(mulc(io[7], 16305), mulc(io[0],  1606));
+    t1a = SUB(mulc(io[7],  1606), mulc(io[0], 16305));
+    t2a = ADD(mulc(io[5], 14449), mulc(io[2],  7723));
+    t3a = SUB(mulc(io[5],  7723), mulc(io[2], 14449));
+    t4a = ADD(mulc(io[3], 10394), mulc(io[4], 12665));
+    t5a = SUB(mulc(io[3], 12665), mulc(io[4], 10394));
+    t6a = ADD(mulc(io[1],  4756), mulc(io[6], 15679));
+    t7a = SUB(mulc(io[1], 15679), mulc(io[6],  4756));
+
+    t0 = rnd14(ADD(t0a, t4a));
+    t1 = rnd14(ADD(t1a, t5a));
+    t2 = rnd14(ADD(t2a, t6a));
+    t3 = rnd14(ADD(t3a, t7a));
+    t4 = rnd14(SUB(t0a, t4a));
+    t5 = rnd14(SUB(t1a, t5a));
+    t6 = rnd14(SUB(t2a, t6a));
+    t7 = rnd14(SUB(t3a, t7a));
+
+    t4a = ADD(mulc(t4, 15137), mulc(t5,  6270));
+    t5a = SUB(mulc(t4,  6270), mulc(t5, 15137));
+    t6a = SUB(mulc(t7, 15137), mulc(t6,  6270));
+    t7a = ADD(mulc(t7,  6270), mulc(t6, 15137));
+
+    io[0] = ADD(t0, t2);
+    io[7] = SUB(zero, ADD(t1, t3));
+    t2    = SUB(t0, t2);
+    t3    = SUB(t1, t3);
+
+    io[1] = SUB(zero, rnd14(ADD(t4a, t6a)));
+    io[6] = rnd14(ADD(t5a, t7a));
+    t6    = rnd14(SUB(t4a, t6a));
+    t7    = rnd14(SUB(t5a, t7a));
+
+    io[3] = SUB(zero, rnd14(mulc(ADD(t2, t3), 11585)));
+    io[4] = rnd14(mulc(SUB(t2, t3), 11585));
+    io[2] = rnd14(mulc(ADD(t6, t7), 11585));
+    io[5] = SUB(zero, rnd14(mulc(SUB(t6, t7), 11585)));
+}
+
+static av_always_inline void idct16_simd128(v128_t *io)
+{
+    v128_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15;
+    v128_t t0a, t1a, t2a, t3a, t4a, t5a, t6a, t7a;
+    v128_t t8a, t9a, t10a, t11a, t12a, t13a, t14a, t15a;
+
+    t0a  = rnd14(mulc(ADD(io[0], io[8]), 11585));
+    t1a  = rnd14(mulc(SUB(io[0], io[8]), 11585));
+    t2a  = rnd14(SUB(mulc(io[4],   6270), mulc(io[12], 15137)));
+    t3a  = rnd14(ADD(mulc(io[4],  15137), mulc(io[12],  6270)));
+    t4a  = rnd14(SUB(mulc(io[2],   3196), mulc(io[14], 16069)));
+    t7a  = rnd14(ADD(mulc(io[2],  16069), mulc(io[14],  3196)));
+    t5a  = rnd14(SUB(mulc(io[10], 13623), mulc(io[6],   9102)));
+    t6a  = rnd14(ADD(mulc(io[10],  9102), mulc(io[6],  13623)));
+    t8a  = rnd14(SUB(mulc(io[1],   1606), mulc(io[15], 16305)));
+    t15a = rnd14(ADD(mulc(io[1],  16305), mulc(io[15],  1606)));
+    t9a  = rnd14(SUB(mulc(io[9],  12665), mulc(io[7],  10394)));
+    t14a = rnd14(ADD(mulc(io[9],  10394), mulc(io[7],  12665)));
+    t10a = rnd14(SUB(mulc(io[5],   7723), mulc(io[11], 14449)));
+    t13a = rnd14(ADD(mulc(io[5],  14449), mulc(io[11],  7723)));
+    t11a = rnd14(SUB(mulc(io[13], 15679), mulc(io[3],   4756)));
+    t12a = rnd14(ADD(mulc(io[13],  4756), mulc(io[3],  15679)));
+
+    t0  = ADD(t0a,  t3a);
+    t1  = ADD(t1a,  t2a);
+    t2  = SUB(t1a,  t2a);
+    t3  = SUB(t0a,  t3a);
+    t4  = ADD(t4a,  t5a);
+    t5  = SUB(t4a,  t5a);
+    t6  = SUB(t7a,  t6a);
+    t7  = ADD(t7a,  t6a);
+    t8  = ADD(t8a,  t9a);
+    t9  = SUB(t8a,  t9a);
+    t10 = SUB(t11a, t10a);
+    t11 = ADD(t11a, t10a);
+    t12 = ADD(t12a, t13a);
+    t13 = SUB(t12a, t13a);
+    t14 = SUB(t15a, t14a);
+    t15 = ADD(t15a, t14a);
+
+    t5a  = rnd14(mulc(SUB(t6, t5), 11585));
+    t6a  = rnd14(mulc(ADD(t6, t5), 11585));
+    t9a  = rnd14(SUB(mulc(t14,  6270), mulc(t9, 15137)));
+    t14a = rnd14(ADD(mulc(t14, 15137), mulc(t9,  6270)));
+    t10a = rnd14(SUB(wasm_i32x4_splat(0),
+                     ADD(mulc(t13, 15137), mulc(t10, 6270))));
+    t13a = rnd14(SUB(mulc(t13,  6270), mulc(t10, 15137)));
+
+    t0a  = ADD(t0,   t7);
+    t1a  = ADD(t1,   t6a);
+    t2a  = ADD(t2,   t5a);
+    t3a  = ADD(t3,   t4);
+    t4   = SUB(t3,   t4);
+    t5   = SUB(t2,   t5a);
+    t6   = SUB(t1,   t6a);
+    t7   = SUB(t0,   t7);
+    t8a  = ADD(t8,   t11);
+    t9   = ADD(t9a,  t10a);
+    t10  = SUB(t9a,  t10a);
+    t11a = SUB(t8,   t11);
+    t12a = SUB(t15,  t12);
+    t13  = SUB(t14a, t13a);
+    t14  = ADD(t14a, t13a);
+    t15a = ADD(t15,  t12);
+
+    t10a = rnd14(mulc(SUB(t13,  t10),  11585));
+    t13a = rnd14(mulc(ADD(t13,  t10),  11585));
+    t11  = rnd14(mulc(SUB(t12a, t11a), 11585));
+    t12  = rnd14(mulc(ADD(t12a, t11a), 11585));
+
+    io[ 0] = ADD(t0a, t15a);
+    io[ 1] = ADD(t1a, t14);
+    io[ 2] = ADD(t2a, t13a);
+    io[ 3] = ADD(t3a, t12);
+    io[ 4] = ADD(t4,  t11);
+    io[ 5] = ADD(t5,  t10a);
+    io[ 6] = ADD(t6,  t9);
+    io[ 7] = ADD(t7,  t8a);
+    io[ 8] = SUB(t7,  t8a);
+    io[ 9] = SUB(t6,  t9);
+    io[10] = SUB(t5,  t10a);
+    io[11] = SUB(t4,  t11);
+    io[12] = SUB(t3a, t12);
+    io[13] = SUB(t2a, t13a);
+    io[14] = SUB(t1a, t14);
+    io[15] = SUB(t0a, t15a);
+}
+
+static av_always_inline void transpose4(v128_t *a, v128_t *b,
+                                        v128_t *c, v128_t *d)
+{
+    v128_t t0 = wasm_i32x4_shuffle(*a, *b, 0, 4, 1, 5);
+    v128_t t1 = wasm_i32x4_shuffle(*c, *d, 0, 4, 1, 5);
+    v128_t t2 = wasm_i32x4_shuffle(*a, *b, 2, 6, 3, 7);
+    v128_t t3 = wasm_i32x4_shuffle(*c, *d, 2, 6, 3, 7);
+
+    *a = wasm_i32x4_shuffle(t0, t1, 0, 1, 4, 5);
+    *b = wasm_i32x4_shuffle(t0, t1, 2, 3, 6, 7);
+    *c = wasm_i32x4_shuffle(t2, t3, 0, 1, 4, 5);
+    *d = wasm_i32x4_shuffle(t2, t3, 2, 3, 6, 7);
+}
+
+/* v[k][g] holds row k, columns 4 * g to 4 * g + 3 */
+static av_always_inline void transpose(v128_t v[16][4], int sz)
+{
+    int i, j, k;
+
+    for (i = 0; i < sz / 4; i++)
+        for (j = i; j < sz / 4; j++) {
+            v128_t a[4], b[4];
+
+            for (k = 0; k < 4; k++) {
+                a[k] = v[4 * i + k][j];
+                b[k] = v[4 * j + k][i];
+            }
+            transpose4(&a[0], &a[1], &a[2], &a[3]);
+            transpose4(&b[0], &b[1], &b[2], &b[3]);
+            for (k = 0; k < 4; k++) {
+                v[4 * j + k][i] = a[k];
+                v[4 * i + k][j] = b[k];
+            }
+        }
+}
+
+static av_always_inline void itxfm_1d(v128_t *io, int sz, int adst)
+{
+    if (sz == 4)
+        adst ? iadst4_simd128(io) : idct4_simd128(io);
+    else if (sz == 8)
+        adst ? iadst8_simd128(io) : idct8_simd128(io);
+    else
+        idct16_simd128(io);
+}
+
+static av_always_inline void add_row(uint8_t *dst, v128_t lo, v128_t hi,
+                                     int bits, int sz)
+{
+    v128_t rnd = wasm_i32x4_splat(1 << (bits - 1)), v;
+
+    lo = wasm_i32x4_shr(wasm_i32x4_add(wrap16(lo), rnd), bits);
+    hi = wasm_i32x4_shr(wasm_i32x4_add(wrap16(hi), rnd), bits);
+    v  = wasm_i16x8_narrow_i32x4(lo, hi);
+    if (sz == 4) {
+        v = wasm_i16x8_add(v, wasm_u16x8_extend_low_u8x16(wasm_v128_load32_zero(dst)));
+        wasm_v128_store32_lane(dst, wasm_u8x16_narrow_i16x8(v, v), 0);
+    } else {
+        v = wasm_i16x8_add(v, wasm_u16x8_load8x8(dst));
+        wasm_v128_store64_lane(dst, wasm_u8x16_narrow_i16x8(v, v), 0);
+    }
+}
+
+/* type_a is the transform of the first pass, done on the columns of block,
+ * type_b the one of the second pass, as in itxfm_wrapper() */
+static av_always_inline void itxfm_add(uint8_t *dst, ptrdiff_t stride,
+                                       int16_t *block, int eob, int sz,
+                                       int bits, int adst_a, int adst_b)
+{
+    v128_t v[16][4];
+    int i, g;
+
+    if (!adst_a && !adst_b && eob == 1) {
+        int t = (((block[0] * 11585 + (1 << 13)) >> 14)
+                            * 11585 + (1 << 13)) >> 14;
+        v128_t dc = wasm_i16x8_splat((t + (1 << (bits - 1))) >> bits);
+
+        block[0] = 0;
+        for (i = 0; i < sz; i++, dst += stride)
+            if (sz == 4) {
+                v128_t v = wasm_u16x8_extend_low_u8x16(wasm_v128_load32_zero(dst));
+
+                v = wasm_i16x8_add(v, dc);
+                wasm_v128_store32_lane(dst, wasm_u8x16_narrow_i16x8(v, v), 0);
+            } else if (sz == 8) {
+                v128_t v = wasm_i16x8_add(wasm_u16x8_load8x8(dst), dc);
+
+                wasm_v128_store64_lane(dst, wasm_u8x16_narrow_i16x8(v, v), 0);
+            } else {
+                v128_t lo = wasm_i16x8_add(wasm_u16x8_load8x8(dst),     dc);
+                v128_t hi = wasm_i16x8_add(wasm_u16x8_load8x8(dst + 8), dc);
+
+                wasm_v128_store(dst, wasm_u8x16_narrow_i16x8(lo, hi));
+            }
+        return;
+    }
+
+    for (i = 0; i < sz; i++)
+        for (g = 0; g < sz / 4; g++)
+            v[i][g] = wasm_i32x4_load16x4(block + i * sz + 4 * g);
+    memset(block, 0, sz * sz * sizeof(*block));
+
+    for (g = 0; g < sz / 4; g++) {
+        v128_t io[16];
+
+        for (i = 0; i < sz; i++)
+            io[i] = v[i][g];
+        itxfm_1d(io, sz, adst_a);
+        for (i = 0; i < sz; i++)
+            v[i][g] = wrap16(io[i]);
+    }
+
+    transpose(v, sz);
+
+    for (g = 0; g < sz / 4; g++) {
+        v128_t io[16];
+
+        for (i = 0; i < sz; i++)
+            io[i] = v[i][g];
+        itxfm_1d(io, sz, adst_b);
+        for (i = 0; i < sz; i++)
+            v[i][g] = io[i];
+    }
+
+    for (i = 0; i < sz; i++, dst += stride)
+        for (g = 0; g < sz / 4; g += 2)
+            add_row(dst + 4 * g, v[i][g], sz == 4 ? v[i][g] : v[i][g + 1],
+                    bits, sz);
+}
+
+#define ITXFM_FUNC(type_a, type_b, sz, bits, adst_a, adst_b)                  \
+static void type_a ## _ ## type_b ## _ ## sz ## x ## sz ## _add_simd128(      \
+    uint8_t *dst, ptrdiff_t stride, int16_t *block, int eob)                  \
+{                                                                             \
+    itxfm_add(dst, stride, block, eob, sz, bits, adst_a, adst_b);             \
+}
+
+ITXFM_FUNC(idct,  idct,  4, 4, 0, 0)
+ITXFM_FUNC(iadst, idct,  4, 4, 1, 0)
+ITXFM_FUNC(idct,  iadst, 4, 4, 0, 1)
+ITXFM_FUNC(iadst, iadst, 4, 4, 1, 1)
+ITXFM_FUNC(idct,  idct,  8, 5, 0, 0)
+ITXFM_FUNC(iadst, idct,  8, 5, 1, 0)
+ITXFM_FUNC(idct,  iadst, 8, 5, 0, 1)
+ITXFM_FUNC(iadst, iadst, 8, 5, 1, 1)
+ITXFM_FUNC(idct,  idct, 16, 6, 0, 0)
+
+/* Loop filter.
+ *
+ * The 8 pixels along the edge are filtered at once, one per 16-bit lane.
+ * All three filters are computed for every lane and the per-lane
+ * fm/flat8in/flat8out/hev masks pick the result that loop_filter() in
+ * vp9dsp.c would have written, so the output is bit-exact. */
+
+static av_always_inline v128_t absdiff(v128_t a, v128_t b)
+{
+    return wasm_i16x8_abs(wasm_i16x8_sub(a, b));
+}
+
+static av_always_inline v128_t clip_int8(v128_t a)
+{
+    return wasm_i16x8_max(wasm_i16x8_min(a, wasm_i16x8_splat(127)),
+                          wasm_i16x8_splat(-128));
+}
+
+/* v[0..15] are p7..p0, q0..q7; p3..q3 (v[4..11]) are enough for wd < 16 */
+static av_always_inline void loop_filter_simd128(v128_t *v, int E, int I,
+                                                 int H, int wd)
+{
+    v128_t in[16];
+    v128_t vI = wasm_i16x8_splat(I), one = wasm_i16x8_splat(1);
+    v128_t fm, hev, f, f1, f2, flat8in, flat8out;
+    int i;
+
+    for (i = wd >= 16 ? 0 : 4; i < (wd >= 16 ? 16 : 12); i++)
+        in[i] = v[i];
+
+#define P(n) in[7 - (n)]
+#define Q(n) in[8 + (n)]
+    fm = wasm_v128_and(wasm_i16x8_le(absdiff(P(3), P(2)), vI),
+                       wasm_i16x8_le(absdiff(P(2), P(1)), vI));
+    fm = wasm_v128_and(fm, wasm_i16x8_le(absdiff(P(1), P(0)), vI));
+    fm = wasm_v128_and(fm, wasm_i16x8_le(absdiff(Q(1), Q(0)), vI));
+    fm = wasm_v128_and(fm, wasm_i16x8_le(absdiff(Q(2), Q(1)), vI));
+    fm = wasm_v128_and(fm, wasm_i16x8_le(absdiff(Q(3), Q(2)), vI));
+    f  = wasm_i16x8_add(wasm_i16x8_shl(absdiff(P(0), Q(0)), 1),
+                        wasm_i16x8_shr(absdiff(P(1), Q(1)), 1));
+    fm = wasm_v128_and(fm, wasm_i16x8_le(f, wasm_i16x8_splat(E)));
+    if (!wasm_v128_any_true(fm))
+        return;
+
+    hev = wasm_v128_or(wasm_i16x8_gt(absdiff(P(1), P(0)), wasm_i16x8_splat(H)),
+                       wasm_i16x8_gt(absdiff(Q(1), Q(0)), wasm_i16x8_splat(H)));
+    f   = wasm_i16x8_sub(Q(0), P(0));
+    f   = wasm_i16x8_add(wasm_i16x8_add(f, f), f);
+    f   = wasm_i16x8_add(f, wasm_v128_and(clip_int8(wasm_i16x8_sub(P(1), Q(1))),
+                                          hev));
+    f   = clip_int8(f);
+    f1  = wasm_i16x8_shr(wasm_i16x8_min(wasm_i16x8_add(f, wasm_i16x8_splat(4)),
+                                        wasm_i16x8_splat(127)), 3);
+    f2  = wasm_i16x8_shr(wasm_i16x8_min(wasm_i16x8_add(f, wasm_i16x8_splat(3)),
+                                        wasm_i16x8_splat(127)), 3);
+    f   = wasm_i16x8_shr(wasm_i16x8_add(f1, one), 1);
+
+    v[7] = wasm_v128_bitselect(wasm_i16x8_add(P(0), f2), P(0), fm);
+    v[8] = wasm_v128_bitselect(wasm_i16x8_sub(Q(0), f1), Q(0), fm);
+    v[6] = wasm_v128_bitselect(wasm_i16x8_add(P(1), f), P(1),
+                               wasm_v128_andnot(fm, hev));
+    v[9] = wasm_v128_bitselect(wasm_i16x8_sub(Q(1), f), Q(1),
+                               wasm_v128_andnot(fm, hev));
+
+    if (wd < 8)
+        return;
+
+    flat8in = wasm_v128_and(fm, wasm_i16x8_le(absdiff(P(3), P(0)), one));
+    flat8in = wasm_v128_and(flat8in, wasm_i16x8_le(absdiff(P(2), P(0)), one));
+    flat8in = wasm_v128_and(flat8in, wasm_i16x8_le(absdiff(P(1), P(0)), one));
+    flat8in = wasm_v128_and(flat8in, wasm_i16x8_le(absdiff(Q(1), Q(0)), one));
+    flat8in = wasm_v128_and(flat8in, wasm_i16x8_le(absdiff(Q(2), Q(0)), one));
+    flat8in = wasm_v128_and(flat8in, wasm_i16x8_le(absdiff(Q(3), Q(0)), one));
+    if (!wasm_v128_any_true(flat8in))
+        return;
+
+    /* Output i of the flat filters is the sum of inputs i - n .. i + n,
+     * repeating the outermost ones, plus input i, rounded. The window is
+     * slid along instead of being summed again for every output. */
+    {
+        v128_t sum = wasm_i16x8_add(wasm_i16x8_mul(P(3), wasm_i16x8_splat(3)),
+                                    wasm_i16x8_splat(4));
+
+        for (i = 5; i <= 8; i++)
+            sum = wasm_i16x8_add(sum, in[i]);
+        for (i = 5; i <= 10; i++) {
+            v[i] = wasm_v128_bitselect(wasm_i16x8_shr(wasm_i16x8_add(sum, in[i]), 3),
+                                       v[i], flat8in);
+            sum  = wasm_i16x8_add(wasm_i16x8_sub(sum, in[FFMAX(i - 3, 4)]),
+                                  in[FFMIN(i + 4, 11)]);
+        }
+    }
+
+    if (wd < 16)
+        return;
+
+    flat8out = wasm_v128_and(flat8in, wasm_i16x8_le(absdiff(P(7), P(0)), one));
+    flat8out = wasm_v128_and(flat8out, wasm_i16x8_le(absdiff(P(6), P(0)), one));
+    flat8out = wasm_v128_and(flat8out, wasm_i16x8_le(absdiff(P(5), P(0)), one));
+    flat8out = wasm_v128_and(flat8out, wasm_i16x8_le(absdiff(P(4), P(0)), one));
+    flat8out = wasm_v128_and(flat8out, wasm_i16x8_le(absdiff(Q(4), Q(0)), one));
+    flat8out = wasm_v128_and(flat8out, wasm_i16x8_le(absdiff(Q(5), Q(0)), one));
+    flat8out = wasm_v128_and(flat8out, wasm_i16x8_le(absdiff(Q(6), Q(0)), one));
+    flat8out = wasm_v128_and(flat8out, wasm_i16x8_le(absdiff(Q(7), Q(0)), one));
+    if (!wasm_v128_any_true(flat8out))
+        return;
+
+    {
+        v128_t sum = wasm_i16x8_add(wasm_i16x8_mul(P(7), wasm_i16x8_splat(7)),
+                                    wasm_i16x8_splat(8));
+
+        for (i = 1; i <= 8; i++)
+            sum = wasm_i16x8_add(sum, in[i]);
+        for (i = 1; i <= 14; i++) {
+            v[i] = wasm_v128_bitselect(wasm_i16x8_shr(wasm_i16x8_add(sum, in[i]), 4),
+                                       v[i], flat8out);
+            sum  = wasm_i16x8_add(wasm_i16x8_sub(sum, in[FFMAX(i - 7, 0)]),
+                                  in[FFMIN(i + 8, 15)]);
+        }
+    }
+#undef P
+#undef Q
+}
+
+/* The row edge filters (v) load the 8 pixels along the edge from one row;
+ * the column edge filters (h) transpose the block around the edge first. */
+static av_always_inline void loop_filter_8px(uint8_t *dst, ptrdiff_t stride,
+                                             int E, int I, int H, int wd,
+                                             int col)
+{
+    uint8_t tmp[16][8];
+    v128_t v[16];
+    int n = wd >= 16 ? 8 : 4, i, j;
+
+    if (col) {
+        for (i = 0; i < 8; i++)
+            for (j = -n; j < n; j++)
+                tmp[8 + j][i] = dst[i * stride + j];
+        for (j = 8 - n; j < 8 + n; j++)
+            v[j] = wasm_u16x8_load8x8(tmp[j]);
+    } else {
+        for (j = 8 - n; j < 8 + n; j++)
+            v[j] = wasm_u16x8_load8x8(dst + (j - 8) * stride);
+    }
+
+    loop_filter_simd128(v, E, I, H, wd);
+
+    if (col) {
+        for (j = 8 - n; j < 8 + n; j++)
+            wasm_v128_store64_lane(tmp[j], wasm_u8x16_narrow_i16x8(v[j], v[j]), 0);
+        for (i = 0; i < 8; i++)
+            for (j = -n; j < n; j++)
+                dst[i * stride + j] = tmp[8 + j][i];
+    } else {
+        for (j = 8 - n; j < 8 + n; j++)
+            wasm_v128_store64_lane(dst + (j - 8) * stride,
+                                   wasm_u8x16_narrow_i16x8(v[j], v[j]), 0);
+    }
+}
+
+#define LF_8_FN(dir, wd, col)                                                 \
+static void loop_filter_ ## dir ## _ ## wd ## _8_simd128(uint8_t *dst,        \
+                                                         ptrdiff_t stride,    \
+                                                         int E, int I, int H) \
+{                                                                             \
+    loop_filter_8px(dst, stride, E, I, H, wd, col);                           \
+}
+
+#define LF_16_FN(dir, col)                                                    \
+static void loop_filter_ ## dir ## _16_16_simd128(uint8_t *dst,               \
+                                                  ptrdiff_t stride,           \
+                                                  int E, int I, int H)        \
+{                                                                             \
+    loop_filter_8px(dst, stride, E, I, H, 16, col);                           \
+    loop_filter_8px(dst + 8 * (col ? stride : 1), stride, E, I, H, 16, col);  \
+}
+
+#define LF_MIX_FN(dir, wd1, wd2, col)                                         \
+static void loop_filter_ ## dir ## _ ## wd1 ## wd2 ## _16_simd128(            \
+    uint8_t *dst, ptrdiff_t stride, int E, int I, int H)                      \
+{                                                                             \
+    loop_filter_8px(dst, stride, E & 0xff, I & 0xff, H & 0xff, wd1, col);     \
+    loop_filter_8px(dst + 8 * (col ? stride : 1), stride,                     \
+                    E >> 8, I >> 8, H >> 8, wd2, col);                        \
+}
+
+#define LF_FNS(dir, col)                                                      \
+LF_8_FN(dir, 4, col)                                                          \
+LF_8_FN(dir, 8, col)                                                          \
+LF_8_FN(dir, 16, col)                                                         \
+LF_16_FN(dir, col)                                                            \
+LF_MIX_FN(dir, 4, 4, col)                                                     \
+LF_MIX_FN(dir, 4, 8, col)                                                     \
+LF_MIX_FN(dir, 8, 4, col)                                                     \
+LF_MIX_FN(dir, 8, 8, col)
+
+LF_FNS(h, 1)
+LF_FNS(v, 0)
+#endif /* HAVE_SIMD128 */
+
+av_cold void ff_vp9dsp_init_wasm(VP9DSPContext *dsp)
+{
+#if HAVE_SIMD128
+    if (!have_simd128(av_get_cpu_flags()))
+        return;
+
+#define init_itxfm(tx, sz)                                                    \
+    dsp->itxfm_add[tx][DCT_DCT]   = idct_idct_   ## sz ## _add_simd128;       \
+    dsp->itxfm_add[tx][DCT_ADST]  = iadst_idct_  ## sz ## _add_simd128;       \
+    dsp->itxfm_add[tx][ADST_DCT]  = idct_iadst_  ## sz ## _add_simd128;       \
+    dsp->itxfm_add[tx][ADST_ADST] = iadst_iadst_ ## sz ## _add_simd128
+
+    init_itxfm(TX_4X4, 4x4);
+    init_itxfm(TX_8X8, 8x8);
+    dsp->itxfm_add[TX_16X16][DCT_DCT] = idct_idct_16x16_add_simd128;
+#undef init_itxfm
+
+    dsp->loop_filter_8[0][0] = loop_filter_h_4_8_simd128;
+    dsp->loop_filter_8[0][1] = loop_filter_v_4_8_simd128;
+    dsp->loop_filter_8[1][0] = loop_filter_h_8_8_simd128;
+    dsp->loop_filter_8[1][1] = loop_filter_v_8_8_simd128;
+    dsp->loop_filter_8[2][0] = loop_filter_h_16_8_simd128;
+    dsp->loop_filter_8[2][1] = loop_filter_v_16_8_simd128;
+
+    dsp->loop_filter_16[0] = loop_filter_h_16_16_simd128;
+    dsp->loop_filter_16[1] = loop_filter_v_16_16_simd128;
+
+    dsp->loop_filter_mix2[0][0][0] = loop_filter_h_44_16_simd128;
+    dsp->loop_filter_mix2[0][0][1] = loop_filter_v_44_16_simd128;
+    dsp->loop_filter_mix2[0][1][0] = loop_filter_h_48_16_simd128;
+    dsp->loop_filter_mix2[0][1][1] = loop_filter_v_48_16_simd128;
+    dsp->loop_filter_mix2[1][0][0] = loop_filter_h_84_16_simd128;
+    dsp->loop_filter_mix2[1][0][1] = loop_filter_v_84_16_simd128;
+    dsp->loop_filter_mix2[1][1][0] = loop_filter_h_88_16_simd128;
+    dsp->loop_filter_mix2[1][1][1] = loop_filter_v_88_16_simd128;
+#endif /* HAVE_SIMD128 */
+}
@@ -860,6 +860,12 @@ struct AVFilterLink {
      * Number of past frames sent through the link.
      */
     int64_t frame_count;
+
+    /**
+     * Pool the default get_video_buffer() takes frames from, for the last
+     * size and format requested on this link.  Private, do not use.
+     */
+    struct FFVideoFramePool *frame_pool;
 };
 
 /**
@@ -0,0 +1,64 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_FRAMEPOOL_H
+#define AVFILTER_FRAMEPOOL_H
+
+#include "libavutil/buffer.h"
+#include "libavutil/frame.h"
+#include "libavutil/pixfmt.h"
+
+/**
+ * Video frame buffers of one size and pixel format, one AVBufferPool per
+ * plane.  Frames taken from it are laid out the same way as with
+ * av_frame_get_buffer(), and their planes go back to the pool when the
+ * last reference to them is dropped.
+ */
+typedef struct FFVideoFramePool {
+    int width;
+    int height;
+    enum AVPixelFormat format;
+    int align;
+    int linesize[4];
+    AVBufferPool *pools[4];
+} FFVideoFramePool;
+
+/**
+ * Allocate a pool for frames of the given size and format.
+ *
+ * @param align linesize alignment, as in av_frame_get_buffer()
+ * @return the new pool, or NULL on error
+ */
+FFVideoFramePool *ff_video_frame_pool_init(int width, int height,
+                                           enum AVPixelFormat format,
+                                           int align);
+
+/**
+ * Free the pool and set *pool to NULL.  Frames still in use stay valid,
+ * their buffers are freed once they are released.
+ */
+void ff_video_frame_pool_uninit(FFVideoFramePool **pool);
+
+/**
+ * Get a frame with buffers from the pool.
+ *
+ * @return a new frame to be freed with av_frame_free(), or NULL on error
+ */
+AVFrame *ff_video_frame_pool_get(FFVideoFramePool *pool);
+
+#endif /* AVFILTER_FRAMEPOOL_H */
@@ -29,6 +29,7 @@
 #include "libavutil/mem.h"
 
 #include "avfilter.h"
+#include "framepool.h"
 #include "internal.h"
 #include "video.h"
 
@@ -37,26 +38,22 @@ AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h)
     return ff_get_video_buffer(link->dst->outputs[0], w, h);
 }
 
-/* TODO: set the buffer's priv member to a context structure for the whole
- * filter chain.  This will allow for a buffer pool instead of the constant
- * alloc & free cycle currently implemented. */
+/* Frames come from a pool on the link, so the buffers of a steady stream
+ * are allocated once instead of for every frame.  The pool is recreated
+ * when the requested size or the link format changes. */
 AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
 {
-    AVFrame *frame = av_frame_alloc();
-    int ret;
+    FFVideoFramePool *pool = link->frame_pool;
 
-    if (!frame)
-        return NULL;
+    if (!pool || pool->width != w || pool->height != h ||
+        pool->format != link->format) {
+        ff_video_frame_pool_uninit(&link->frame_pool);
+        link->frame_pool = ff_video_frame_pool_init(w, h, link->format, 32);
+        if (!link->frame_pool)
+            return NULL;
+    }
 
-    frame->width  = w;
-    frame->height = h;
-    frame->format = link->format;
-
-    ret = av_frame_get_buffer(frame, 32);
-    if (ret < 0)
-        av_frame_free(&frame);
-
-    return frame;
+    return ff_video_frame_pool_get(link->frame_pool);
 }
 
 #if FF_API_AVFILTERBUFFER
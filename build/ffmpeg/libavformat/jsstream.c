@@ -0,0 +1,157 @@
+/*
+ * JavaScript callback backed I/O for Emscripten builds
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * jsstream: protocol. Reads and writes go straight to JavaScript callbacks
+ * registered by name, so neither the input nor the output has to be copied
+ * into the in-memory filesystem first.
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/opt.h"
+#include "avformat.h"
+#include "url.h"
+
+/* Implemented in JavaScript and linked in with emcc --js-library.
+ * Positions are passed as doubles, which hold any file offset exactly
+ * and need no 64-bit integer legalization at the JS boundary. */
+extern int    ff_jsstream_open(const char *name, int flags);
+extern int    ff_jsstream_read(int handle, uint8_t *buf, int size, double pos);
+extern int    ff_jsstream_write(int handle, const uint8_t *buf, int size, double pos);
+extern double ff_jsstream_size(int handle);
+extern void   ff_jsstream_close(int handle);
+
+typedef struct JSStreamContext {
+    const AVClass *class;
+    int handle;
+    int64_t pos;
+    int64_t size;
+    int blocksize;
+} JSStreamContext;
+
+static const AVOption jsstream_options[] = {
+    { "blocksize", "set I/O operation maximum block size", offsetof(JSStreamContext, blocksize), AV_OPT_TYPE_INT, { .i64 = INT_MAX }, 1, INT_MAX, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { NULL }
+};
+
+static const AVClass jsstream_class = {
+    .class_name = "jsstream",
+    .item_name  = av_default_item_name,
+    .option     = jsstream_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
+static int jsstream_open(URLContext *h, const char *filename, int flags)
+{
+    JSStreamContext *c = h->priv_data;
+    double size;
+
+    av_strstart(filename, "jsstream:", &filename);
+
+    c->handle = ff_jsstream_open(filename, flags);
+    if (c->handle < 0)
+        return AVERROR(ENOENT);
+
+    /* outputs start out empty, inputs of unknown size cannot be seeked in */
+    size = ff_jsstream_size(c->handle);
+    if (size >= 0)
+        c->size = size;
+    else
+        c->size = flags & AVIO_FLAG_WRITE ? 0 : -1;
+    c->pos = 0;
+    h->is_streamed = c->size < 0;
+
+    return 0;
+}
+
+static int jsstream_read(URLContext *h, unsigned char *buf, int size)
+{
+    JSStreamContext *c = h->priv_data;
+    int r;
+
+    size = FFMIN(size, c->blocksize);
+    r = ff_jsstream_read(c->handle, buf, size, c->pos);
+    if (r < 0)
+        return AVERROR(EIO);
+    c->pos += r;
+    return r;
+}
+
+/* Every chunk is handed over with its absolute position, so muxers that
+ * seek back to patch headers (mov, matroska) still work. */
+static int jsstream_write(URLContext *h, const unsigned char *buf, int size)
+{
+    JSStreamContext *c = h->priv_data;
+    int r;
+
+    size = FFMIN(size, c->blocksize);
+    r = ff_jsstream_write(c->handle, buf, size, c->pos);
+    if (r < 0)
+        return AVERROR(EIO);
+    c->pos += r;
+    c->size = FFMAX(c->size, c->pos);
+    return r;
+}
+
+static int64_t jsstream_seek(URLContext *h, int64_t pos, int whence)
+{
+    JSStreamContext *c = h->priv_data;
+
+    switch (whence) {
+    case AVSEEK_SIZE:
+        return c->size < 0 ? AVERROR(ENOSYS) : c->size;
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        pos += c->pos;
+        break;
+    case SEEK_END:
+        if (c->size < 0)
+            return AVERROR(ENOSYS);
+        pos += c->size;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    c->pos = pos;
+    return pos;
+}
+
+static int jsstream_close(URLContext *h)
+{
+    JSStreamContext *c = h->priv_data;
+    ff_jsstream_close(c->handle);
+    return 0;
+}
+
+URLProtocol ff_jsstream_protocol = {
+    .name                = "jsstream",
+    .url_open            = jsstream_open,
+    .url_read            = jsstream_read,
+    .url_write           = jsstream_write,
+    .url_seek            = jsstream_seek,
+    .url_close           = jsstream_close,
+    .priv_data_size      = sizeof(JSStreamContext),
+    .priv_data_class     = &jsstream_class,
+};
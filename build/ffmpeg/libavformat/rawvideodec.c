@@ -30,6 +30,8 @@ typedef struct RawVideoDemuxerContext {
     int width, height;        /**< Integers describing video size, set by a private option. */
     char *pixel_format;       /**< Set by a private option. */
     AVRational framerate;     /**< AVRational describing framerate, set by a private option. */
+    AVBufferPool *pool;       /**< Packet buffers, all frames have the same size. */
+    int pool_size;
 } RawVideoDemuxerContext;
 
 
@@ -67,6 +69,7 @@ static int rawvideo_read_header(AVFormatContext *ctx)
 
 static int rawvideo_read_packet(AVFormatContext *s, AVPacket *pkt)
 {
+    RawVideoDemuxerContext *raw = s->priv_data;
     int packet_size, ret, width, height;
     AVStream *st = s->streams[0];
 
@@ -77,12 +80,44 @@ static int rawvideo_read_packet(AVFormatContext *s, AVPacket *pkt)
     if (packet_size < 0)
         return -1;
 
-    ret = av_get_packet(s->pb, pkt, packet_size);
-    pkt->pts = pkt->dts = pkt->pos / packet_size;
+    /* Every packet is a whole frame of the same size, so the buffers come
+     * from a pool instead of one allocation per frame, which adds up for
+     * large pictures. */
+    if (packet_size != raw->pool_size) {
+        av_buffer_pool_uninit(&raw->pool);
+        raw->pool = av_buffer_pool_init(packet_size + FF_INPUT_BUFFER_PADDING_SIZE, NULL);
+        if (!raw->pool)
+            return AVERROR(ENOMEM);
+        raw->pool_size = packet_size;
+    }
+
+    av_init_packet(pkt);
+    pkt->pos = avio_tell(s->pb);
+    pkt->buf = av_buffer_pool_get(raw->pool);
+    if (!pkt->buf)
+        return AVERROR(ENOMEM);
+    pkt->data = pkt->buf->data;
+
+    ret = avio_read(s->pb, pkt->data, packet_size);
+    if (ret <= 0) {
+        av_free_packet(pkt);
+        return ret < 0 ? ret : AVERROR_EOF;
+    }
+    pkt->size = ret;
+    memset(pkt->data + pkt->size, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+    if (ret < packet_size)
+        pkt->flags |= AV_PKT_FLAG_CORRUPT;
 
+    pkt->pts = pkt->dts = pkt->pos / packet_size;
     pkt->stream_index = 0;
-    if (ret < 0)
-        return ret;
+    return 0;
+}
+
+static int rawvideo_read_close(AVFormatContext *s)
+{
+    RawVideoDemuxerContext *raw = s->priv_data;
+
+    av_buffer_pool_uninit(&raw->pool);
     return 0;
 }
 
@@ -108,6 +143,7 @@ AVInputFormat ff_rawvideo_demuxer = {
     .priv_data_size = sizeof(RawVideoDemuxerContext),
     .read_header    = rawvideo_read_header,
     .read_packet    = rawvideo_read_packet,
+    .read_close     = rawvideo_read_close,
     .flags          = AVFMT_GENERIC_INDEX,
     .extensions     = "yuv,cif,qcif,rgb",
     .raw_codec_id   = AV_CODEC_ID_RAWVIDEO,
@@ -24,31 +24,25 @@
 #include "common.h"
 #include "mem.h"
 
-AVBufferRef *av_buffer_create(uint8_t *data, int size,
-                              void (*free)(void *opaque, uint8_t *data),
-                              void *opaque, int flags)
+static AVBufferRef *buffer_create(AVBuffer *buf, uint8_t *data, int size,
+                                  void (*free)(void *opaque, uint8_t *data),
+                                  void *opaque, int flags)
 {
     AVBufferRef *ref = NULL;
-    AVBuffer    *buf = NULL;
-
-    buf = av_mallocz(sizeof(*buf));
-    if (!buf)
-        return NULL;
 
     buf->data     = data;
     buf->size     = size;
     buf->free     = free ? free : av_buffer_default_free;
     buf->opaque   = opaque;
     buf->refcount = 1;
+    buf->flags    = 0;
 
     if (flags & AV_BUFFER_FLAG_READONLY)
         buf->flags |= BUFFER_FLAG_READONLY;
 
     ref = av_mallocz(sizeof(*ref));
-    if (!ref) {
-        av_freep(&buf);
+    if (!ref)
         return NULL;
-    }
 
     ref->buffer = buf;
     ref->data   = data;
@@ -57,6 +51,24 @@ AVBufferRef *av_buffer_create(uint8_t *data, int size,
     return ref;
 }
 
+AVBufferRef *av_buffer_create(uint8_t *data, int size,
+                              void (*free)(void *opaque, uint8_t *data),
+                              void *opaque, int flags)
+{
+    AVBufferRef *ref;
+    AVBuffer    *buf = av_mallocz(sizeof(*buf));
+    if (!buf)
+        return NULL;
+
+    ref = buffer_create(buf, data, size, free, opaque, flags);
+    if (!ref) {
+        av_freep(&buf);
+        return NULL;
+    }
+
+    return ref;
+}
+
 void av_buffer_default_free(void *opaque, uint8_t *data)
 {
     av_free(data);
@@ -112,8 +124,12 @@ void av_buffer_unref(AVBufferRef **buf)
     av_freep(buf);
 
     if (!avpriv_atomic_int_add_and_fetch(&b->refcount, -1)) {
+        /* b->free() may free the structure b is embedded in,
+         * so the flag has to be read before calling it */
+        int free_avbuffer = !(b->flags & BUFFER_FLAG_NO_FREE);
         b->free(b->opaque, b->data);
-        av_freep(&b);
+        if (free_avbuffer)
+            av_freep(&b);
     }
 }
 
@@ -346,9 +362,11 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
     add_to_pool(buf->next);
     buf->next = NULL;
 
-    ret = av_buffer_create(buf->data, pool->size, pool_release_buffer,
-                           buf, 0);
-    if (!ret) {
+    ret = buffer_create(&buf->buffer, buf->data, pool->size,
+                        pool_release_buffer, buf, 0);
+    if (ret)
+        buf->buffer.flags |= BUFFER_FLAG_NO_FREE;
+    else {
         add_to_pool(buf);
         return NULL;
     }
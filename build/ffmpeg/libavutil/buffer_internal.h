@@ -31,6 +31,11 @@
  * The buffer was av_realloc()ed, so it is reallocatable.
  */
 #define BUFFER_FLAG_REALLOCATABLE (1 << 1)
+/**
+ * The AVBuffer structure is part of a larger structure
+ * and should not be freed.
+ */
+#define BUFFER_FLAG_NO_FREE       (1 << 2)
 
 struct AVBuffer {
     uint8_t *data; /**< data described by this buffer */
@@ -60,6 +65,12 @@ struct AVBuffer {
 typedef struct BufferPoolEntry {
     uint8_t *data;
 
+    /*
+     * The AVBuffer handed out for this entry once it has been recycled, so
+     * that getting a buffer from the pool only allocates the AVBufferRef.
+     */
+    AVBuffer buffer;
+
     /*
      * Backups of the original opaque/free of the AVBuffer corresponding to
      * data. They will be used to free the buffer when the pool is freed.
@@ -65,6 +65,8 @@
 #define AV_CPU_FLAG_NEON         (1 << 5)
 #define AV_CPU_FLAG_ARMV8        (1 << 6)
 
+#define AV_CPU_FLAG_SIMD128      (1 << 0) ///< WebAssembly 128-bit packed SIMD
+
 /**
  * Return the flags which specify extensions supported by the CPU.
  * The returned value is affected by av_force_cpu_flags() if that was used
@@ -29,6 +29,7 @@
 int ff_get_cpu_flags_aarch64(void);
 int ff_get_cpu_flags_arm(void);
 int ff_get_cpu_flags_ppc(void);
+int ff_get_cpu_flags_wasm(void);
 int ff_get_cpu_flags_x86(void);
 
 #endif /* AVUTIL_CPU_INTERNAL_H */
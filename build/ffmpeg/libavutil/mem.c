@@ -50,12 +50,14 @@
 #define posix_memalign AV_JOIN(MALLOC_PREFIX, posix_memalign)
 #define realloc        AV_JOIN(MALLOC_PREFIX, realloc)
 #define free           AV_JOIN(MALLOC_PREFIX, free)
+#define malloc_usable_size AV_JOIN(MALLOC_PREFIX, malloc_usable_size)
 
 void *malloc(size_t size);
 void *memalign(size_t align, size_t size);
 int   posix_memalign(void **ptr, size_t align, size_t size);
 void *realloc(void *ptr, size_t size);
 void  free(void *ptr);
+size_t malloc_usable_size(void *ptr);
 
 #endif /* MALLOC_PREFIX */
 
@@ -72,6 +74,89 @@ void av_max_alloc(size_t max){
     max_alloc_size = max;
 }
 
+/* Allocation statistics for av_mem_stats(). The size of a block is taken
+ * from the allocator, so nothing has to be stored next to it; the blocks of
+ * the memalign hack and _aligned_malloc() cannot be measured that way. The
+ * counters are 64-bit, so they are only kept with the gcc atomic builtins,
+ * and only while av_mem_stats_enable() has turned them on. */
+#define MEM_STATS (HAVE_MALLOC_USABLE_SIZE && HAVE_ATOMICS_GCC && \
+                   !CONFIG_MEMALIGN_HACK && !HAVE_ALIGNED_MALLOC)
+
+#if MEM_STATS
+static volatile int mem_stats_enabled;
+static volatile int64_t mem_current;
+static volatile int64_t mem_peak;
+static volatile int64_t mem_nb_allocs;
+
+static void mem_stats_add(int64_t size, int new_block)
+{
+    int64_t current = __sync_add_and_fetch(&mem_current, size);
+    int64_t peak    = mem_peak;
+
+    if (new_block)
+        __sync_add_and_fetch(&mem_nb_allocs, 1);
+    while (current > peak) {
+        int64_t old = __sync_val_compare_and_swap(&mem_peak, peak, current);
+        if (old == peak)
+            break;
+        peak = old;
+    }
+}
+#endif
+
+static void mem_stats_update(void *ptr, int sign)
+{
+#if MEM_STATS
+    if (!mem_stats_enabled || !ptr)
+        return;
+    mem_stats_add(sign * (int64_t)malloc_usable_size(ptr), sign > 0);
+#endif
+}
+
+void av_mem_stats_enable(int enable)
+{
+#if MEM_STATS
+    if (enable && !mem_stats_enabled) {
+        __sync_lock_test_and_set(&mem_current,   0);
+        __sync_lock_test_and_set(&mem_peak,      0);
+        __sync_lock_test_and_set(&mem_nb_allocs, 0);
+    }
+    mem_stats_enabled = !!enable;
+    __sync_synchronize();
+#endif
+}
+
+void av_mem_stats(int64_t *current, int64_t *peak)
+{
+#if MEM_STATS
+    if (current)
+        *current = FFMAX(__sync_add_and_fetch(&mem_current, 0), 0);
+    if (peak)
+        *peak = __sync_add_and_fetch(&mem_peak, 0);
+#else
+    if (current)
+        *current = 0;
+    if (peak)
+        *peak = 0;
+#endif
+}
+
+void av_mem_reset_peak(void)
+{
+#if MEM_STATS
+    __sync_lock_test_and_set(&mem_peak, __sync_add_and_fetch(&mem_current, 0));
+#endif
+}
+
+int64_t av_mem_nb_allocs(void)
+{
+#if MEM_STATS
+    return __sync_add_and_fetch(&mem_nb_allocs, 0);
+#else
+    return 0;
+#endif
+}
+
 void *av_malloc(size_t size)
 {
     void *ptr = NULL;
@@ -132,7 +217,8 @@ void *av_malloc(size_t size)
     if(!ptr && !size) {
         size = 1;
         ptr= av_malloc(1);
-    }
+    } else
+        mem_stats_update(ptr, 1);
 #if CONFIG_MEMORY_POISONING
     if (ptr)
         memset(ptr, FF_MEMORY_POISON, size);
@@ -162,6 +248,16 @@ void *av_realloc(void *ptr, size_t size)
     return ptr;
 #elif HAVE_ALIGNED_MALLOC
     return _aligned_realloc(ptr, size + !size, ALIGN);
+#elif MEM_STATS
+    if (mem_stats_enabled) {
+        /* measured first, the old block is gone after a successful realloc */
+        int64_t old_size = ptr ? malloc_usable_size(ptr) : 0;
+        void *new_ptr = realloc(ptr, size + !size);
+        if (new_ptr)
+            mem_stats_add((int64_t)malloc_usable_size(new_ptr) - old_size, 1);
+        return new_ptr;
+    }
+    return realloc(ptr, size + !size);
 #else
     return realloc(ptr, size + !size);
 #endif
@@ -229,6 +325,7 @@ void av_free(void *ptr)
 #elif HAVE_ALIGNED_MALLOC
     _aligned_free(ptr);
 #else
+    mem_stats_update(ptr, -1);
     free(ptr);
 #endif
 }
@@ -339,6 +339,49 @@ static inline int av_size_mult(size_t a, size_t b, size_t *r)
  */
 void av_max_alloc(size_t max);
 
+/**
+ * Turn the allocation statistics of av_mem_stats() and av_mem_nb_allocs()
+ * on or off. They are off by default and cost nothing then; while on, every
+ * allocation and free asks the system allocator for the block size and
+ * updates the counters atomically.
+ *
+ * Turning them on restarts all counters from 0, so they count from that
+ * point on. Blocks allocated while they were off are not counted, but freeing
+ * them while they are on is, so the current allocation only counts what was
+ * allocated since, less what was freed, and is reported as 0 when that is
+ * negative.
+ *
+ * @param enable nonzero to turn the statistics on, 0 to turn them off
+ */
+void av_mem_stats_enable(int enable);
+
+/**
+ * Get the number of bytes currently allocated with av_malloc() and related
+ * functions, and the highest that number has been since the statistics were
+ * turned on or the last av_mem_reset_peak().
+ *
+ * Sizes are those the system allocator reports for each block, so they
+ * include its rounding. Both are 0 when av_mem_stats_enable() has not been
+ * called, and where the sizes cannot be measured (no malloc_usable_size(),
+ * no atomics, or --enable-memalign-hack).
+ *
+ * @param current if not NULL, set to the bytes currently allocated
+ * @param peak    if not NULL, set to the peak allocation
+ */
+void av_mem_stats(int64_t *current, int64_t *peak);
+
+/**
+ * Restart the peak reported by av_mem_stats() from the current allocation.
+ */
+void av_mem_reset_peak(void);
+
+/**
+ * Get the number of blocks allocated or reallocated with av_malloc(),
+ * av_realloc() and related functions while the statistics were on, 0 where
+ * av_mem_stats() cannot report allocations either.
+ */
+int64_t av_mem_nb_allocs(void);
+
 /**
  * deliberately overlapping memcpy implementation
  * @param dst destination buffer
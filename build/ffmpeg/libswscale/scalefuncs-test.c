@@ -0,0 +1,258 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Compare the optimized scaler and YUV to RGB functions selected for this
+ * CPU against the C reference, which must be matched bit for bit.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/cpu.h"
+#include "libavutil/lfg.h"
+#include "libavutil/log.h"
+#include "libavutil/pixdesc.h"
+
+#include "swscale.h"
+#include "swscale_internal.h"
+
+#define SRC_W      1024
+#define MAX_DST_W  SRC_W
+#define MAX_FILTER 16
+
+static AVLFG prng;
+
+static SwsContext *get_context(int dst_w, int cpu_flags)
+{
+    av_force_cpu_flags(cpu_flags);
+    return sws_getContext(SRC_W, 16, AV_PIX_FMT_YUV420P,
+                          dst_w, 16, AV_PIX_FMT_YUV420P,
+                          SWS_BICUBIC | SWS_ACCURATE_RND, NULL, NULL, NULL);
+}
+
+/* Both sides are fed the filter built for the optimized context, since its
+ * size and padding are what the optimized function was selected for. */
+static int check_hscale(SwsContext *ref, SwsContext *opt, int dst_w)
+{
+    uint8_t src[SRC_W + MAX_FILTER * 4];
+    int16_t dst_ref[MAX_DST_W], dst_opt[MAX_DST_W];
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(src); i++)
+        src[i] = av_lfg_get(&prng);
+
+    ref->hyScale(ref, dst_ref, dst_w, src, opt->hLumFilter,
+                 opt->hLumFilterPos, opt->hLumFilterSize);
+    opt->hyScale(opt, dst_opt, dst_w, src, opt->hLumFilter,
+                 opt->hLumFilterPos, opt->hLumFilterSize);
+    if (memcmp(dst_ref, dst_opt, sizeof(*dst_ref) * dst_w)) {
+        fprintf(stderr, "hyScale mismatch, dstW=%d filterSize=%d\n",
+                dst_w, opt->hLumFilterSize);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int check_yuv2planeX(SwsContext *ref, SwsContext *opt, int dst_w)
+{
+    static int16_t src[MAX_FILTER][MAX_DST_W];
+    const int16_t *srcp[MAX_FILTER];
+    int16_t filter[MAX_FILTER];
+    uint8_t dither[8], dst_ref[MAX_DST_W], dst_opt[MAX_DST_W];
+    int i, j, size;
+
+    for (size = 1; size <= MAX_FILTER; size++) {
+        for (j = 0; j < size; j++) {
+            filter[j] = (int)(av_lfg_get(&prng) % 8192) - 2048;
+            for (i = 0; i < dst_w; i++)
+                src[j][i] = av_lfg_get(&prng) & 0x7fff;
+            srcp[j] = src[j];
+        }
+        for (i = 0; i < 8; i++)
+            dither[i] = av_lfg_get(&prng) & 0x7f;
+
+        ref->yuv2planeX(filter, size, srcp, dst_ref, dst_w, dither, size & 7);
+        opt->yuv2planeX(filter, size, srcp, dst_opt, dst_w, dither, size & 7);
+        if (memcmp(dst_ref, dst_opt, dst_w)) {
+            fprintf(stderr, "yuv2planeX mismatch, dstW=%d filterSize=%d\n",
+                    dst_w, size);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* Chroma gets the occasional negative tap so that the clipping of U and V
+ * to the table headroom is hit as well. */
+static int check_yuv2packedX(SwsContext *ref, SwsContext *opt, int dst_w)
+{
+    static int16_t lum[MAX_FILTER][MAX_DST_W + 1];
+    static int16_t chr[2][MAX_FILTER][MAX_DST_W / 2 + 1];
+    const int16_t *lump[MAX_FILTER], *chrp[2][MAX_FILTER];
+    int16_t filter[MAX_FILTER];
+    uint32_t dst_ref[MAX_DST_W + 1], dst_opt[MAX_DST_W + 1];
+    int i, j, size, sum;
+
+    for (size = 1; size <= MAX_FILTER; size++) {
+        /* also cover the pixel pairs left over after whole groups of 8 */
+        int w = dst_w - 2 * (size & 3);
+
+        for (j = 0, sum = 0; j < size - 1; j++) {
+            filter[j] = j ? av_lfg_get(&prng) % (4096 / size + 1)
+                          : -(int)(av_lfg_get(&prng) % 256);
+            sum += filter[j];
+        }
+        filter[size - 1] = 4096 - sum;
+
+        for (j = 0; j < size; j++) {
+            for (i = 0; i < dst_w + 1; i++)
+                lum[j][i] = av_lfg_get(&prng) & 0x7fff;
+            for (i = 0; i < dst_w / 2 + 1; i++) {
+                chr[0][j][i] = av_lfg_get(&prng) & 0x7fff;
+                chr[1][j][i] = av_lfg_get(&prng) & 0x7fff;
+            }
+            lump[j]    = lum[j];
+            chrp[0][j] = chr[0][j];
+            chrp[1][j] = chr[1][j];
+        }
+
+        ref->yuv2packedX(ref, filter, lump, size, filter, chrp[0], chrp[1],
+                         size, NULL, (uint8_t *)dst_ref, w, 0);
+        opt->yuv2packedX(opt, filter, lump, size, filter, chrp[0], chrp[1],
+                         size, NULL, (uint8_t *)dst_opt, w, 0);
+        if (memcmp(dst_ref, dst_opt, sizeof(*dst_ref) * w)) {
+            fprintf(stderr, "yuv2packedX mismatch, %s dstW=%d filterSize=%d\n",
+                    av_get_pix_fmt_name(opt->dstFormat), w, size);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* The unscaled converters are run through sws_scale() on a 4:2:0 or 4:2:2
+ * picture, so that the slice and stride handling is covered too. */
+static int check_yuv2rgb(enum AVPixelFormat src_fmt, enum AVPixelFormat dst_fmt,
+                         int w)
+{
+    static uint8_t planes[3][SRC_W * 16];
+    static uint8_t dst_ref[SRC_W * 4 * 16], dst_opt[SRC_W * 4 * 16];
+    const uint8_t *src[4] = { planes[0], planes[1], planes[2], NULL };
+    int src_stride[4] = { SRC_W, SRC_W / 2, SRC_W / 2, 0 };
+    int dst_stride[4] = { SRC_W * 4, 0, 0, 0 };
+    uint8_t *dst[4] = { NULL };
+    SwsContext *ref, *opt;
+    int i, j, ret = 0;
+
+    av_force_cpu_flags(0);
+    ref = sws_getContext(w, 16, src_fmt, w, 16, dst_fmt, SWS_BILINEAR,
+                         NULL, NULL, NULL);
+    av_force_cpu_flags(-1);
+    opt = sws_getContext(w, 16, src_fmt, w, 16, dst_fmt, SWS_BILINEAR,
+                         NULL, NULL, NULL);
+    if (!ref || !opt)
+        return 2;
+
+    if (ref->swscale != opt->swscale) {
+        for (i = 0; i < 3; i++)
+            for (j = 0; j < FF_ARRAY_ELEMS(planes[i]); j++)
+                planes[i][j] = av_lfg_get(&prng);
+        memset(dst_ref, 0, sizeof(dst_ref));
+        memset(dst_opt, 0, sizeof(dst_opt));
+
+        dst[0] = dst_ref;
+        sws_scale(ref, src, src_stride, 0, 16, dst, dst_stride);
+        dst[0] = dst_opt;
+        sws_scale(opt, src, src_stride, 0, 16, dst, dst_stride);
+        if (memcmp(dst_ref, dst_opt, sizeof(dst_ref))) {
+            fprintf(stderr, "yuv2rgb mismatch, %s to %s w=%d\n",
+                    av_get_pix_fmt_name(src_fmt), av_get_pix_fmt_name(dst_fmt), w);
+            ret = 1;
+        }
+    }
+
+    sws_freeContext(ref);
+    sws_freeContext(opt);
+    return ret;
+}
+
+int main(void)
+{
+    static const enum AVPixelFormat rgb_fmts[] = {
+        AV_PIX_FMT_RGBA, AV_PIX_FMT_BGRA, AV_PIX_FMT_ARGB, AV_PIX_FMT_ABGR
+    };
+    static const int dst_widths[] = { 1007, 640, 333, 1024 };
+    int n, i, ret = 0;
+
+    av_lfg_init(&prng, 0xdeadbeef);
+    /* the C references warn about missing accelerated conversions */
+    av_log_set_level(AV_LOG_ERROR);
+
+    for (n = 0; n < FF_ARRAY_ELEMS(dst_widths); n++) {
+        int dst_w = dst_widths[n];
+        SwsContext *ref = get_context(dst_w, 0);
+        SwsContext *opt = get_context(dst_w, -1);
+
+        if (!ref || !opt)
+            return 2;
+
+        if (ref->hyScale != opt->hyScale)
+            ret |= check_hscale(ref, opt, dst_w);
+        /* the MMX vertical scaler reads its coefficients from the context
+         * instead of the filter argument, so it cannot be driven directly */
+        if (ref->yuv2planeX != opt->yuv2planeX && !opt->use_mmx_vfilter)
+            ret |= check_yuv2planeX(ref, opt, dst_w);
+
+        sws_freeContext(ref);
+        sws_freeContext(opt);
+    }
+
+    for (n = 0; n < FF_ARRAY_ELEMS(dst_widths); n++) {
+        int dst_w = dst_widths[n];
+
+        for (i = 0; i < FF_ARRAY_ELEMS(rgb_fmts); i++) {
+            SwsContext *ref, *opt;
+
+            av_force_cpu_flags(0);
+            ref = sws_getContext(SRC_W, 16, AV_PIX_FMT_YUV420P,
+                                 dst_w, 12, rgb_fmts[i],
+                                 SWS_BICUBIC, NULL, NULL, NULL);
+            av_force_cpu_flags(-1);
+            opt = sws_getContext(SRC_W, 16, AV_PIX_FMT_YUV420P,
+                                 dst_w, 12, rgb_fmts[i],
+                                 SWS_BICUBIC, NULL, NULL, NULL);
+            if (!ref || !opt)
+                return 2;
+
+            if (ref->yuv2packedX != opt->yuv2packedX)
+                ret |= check_yuv2packedX(ref, opt, dst_w);
+
+            sws_freeContext(ref);
+            sws_freeContext(opt);
+
+            ret |= check_yuv2rgb(AV_PIX_FMT_YUV420P, rgb_fmts[i], dst_w & ~1);
+            ret |= check_yuv2rgb(AV_PIX_FMT_YUV422P, rgb_fmts[i], dst_w & ~1);
+        }
+    }
+
+    return ret;
+}
@@ -326,6 +326,13 @@ typedef struct SwsContext {
 
     uint8_t *formatConvBuffer;
 
+    /* Scratch copies of the source made by sws_scale() for the rgb0 and
+     * xyz inputs, kept between calls so they are allocated only once. */
+    uint8_t *rgb0_scratch;
+    unsigned int rgb0_scratch_allocated;
+    uint8_t *xyz_scratch;
+    unsigned int xyz_scratch_allocated;
+
     /**
      * @name Horizontal and vertical filters.
      * To better understand the following fields, here is a pseudo-code of
@@ -404,6 +411,16 @@ typedef struct SwsContext {
     int yuv2rgb_v2g_coeff;
     int yuv2rgb_u2g_coeff;
     int yuv2rgb_u2b_coeff;
+    /* Parameters the 32-bit yuv2rgb tables are built from: entry i of the
+     * luma table is av_clip_uint8((i * cy + yb + 0x8000) >> 16) and a chroma
+     * value c moves the lookup by yoffs + (c * coeff >> 16) - (coeff >> 9). */
+    int yuv2rgb_table_cy;
+    int yuv2rgb_table_yb;
+    int yuv2rgb_table_yoffs;
+    int yuv2rgb_table_crv;
+    int yuv2rgb_table_cbu;
+    int yuv2rgb_table_cgu;
+    int yuv2rgb_table_cgv;
 
 #define RED_DITHER            "0*8"
 #define GREEN_DITHER          "1*8"
@@ -608,6 +625,7 @@ av_cold void ff_sws_init_range_convert(SwsContext *c);
 
 SwsFunc ff_yuv2rgb_init_x86(SwsContext *c);
 SwsFunc ff_yuv2rgb_init_ppc(SwsContext *c);
+SwsFunc ff_yuv2rgb_init_wasm(SwsContext *c);
 
 #if FF_API_SWS_FORMAT_NAME
 /**
@@ -855,6 +873,7 @@ void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2packedX_fn *yuv2packedX,
                               yuv2anyX_fn *yuv2anyX);
 void ff_sws_init_swscale_ppc(SwsContext *c);
+void ff_sws_init_swscale_wasm(SwsContext *c);
 void ff_sws_init_swscale_x86(SwsContext *c);
 
 static inline void fillPlane16(uint8_t *plane, int stride, int width, int height, int y,
@@ -47,6 +47,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/ppc/cpu.h"
+#include "libavutil/wasm/cpu.h"
 #include "libavutil/x86/asm.h"
 #include "libavutil/x86/cpu.h"
 #include "rgb2rgb.h"
@@ -1624,6 +1625,8 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
             cpucaps = "MMX";
         else if (PPC_ALTIVEC(cpu_flags))
             cpucaps = "AltiVec";
+        else if (have_simd128(cpu_flags))
+            cpucaps = "SIMD128";
         else
             cpucaps = "C";
 
@@ -2068,6 +2071,8 @@ void sws_freeContext(SwsContext *c)
 
     av_freep(&c->yuvTable);
     av_freep(&c->formatConvBuffer);
+    av_freep(&c->rgb0_scratch);
+    av_freep(&c->xyz_scratch);
 
     av_free(c);
 }
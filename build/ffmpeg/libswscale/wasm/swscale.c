@@ -0,0 +1,198 @@
+/*
+ * WebAssembly SIMD128 optimized scaler functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/wasm/cpu.h"
+
+#if HAVE_SIMD128
+#include <wasm_simd128.h>
+
+#include "yuv2rgb.h"
+
+/* All arithmetic below is done on 32-bit lanes with the same wrap-around
+ * behaviour as the int accumulators of the C versions, so the output is
+ * bit-exact with hScale8To15_c and yuv2planeX_8_c. */
+
+static void hscale8to15_simd128(SwsContext *c, int16_t *dst, int dstW,
+                                const uint8_t *src, const int16_t *filter,
+                                const int32_t *filterPos, int filterSize)
+{
+    int i;
+
+    for (i = 0; i < dstW; i++) {
+        const uint8_t *s = src + filterPos[i];
+        const int16_t *f = filter + filterSize * i;
+        v128_t acc = wasm_i32x4_splat(0);
+        int j, val;
+
+        for (j = 0; j + 8 <= filterSize; j += 8)
+            acc = wasm_i32x4_add(acc,
+                                 wasm_i32x4_dot_i16x8(wasm_u16x8_load8x8(s + j),
+                                                      wasm_v128_load(f + j)));
+        val = wasm_i32x4_extract_lane(acc, 0) + wasm_i32x4_extract_lane(acc, 1) +
+              wasm_i32x4_extract_lane(acc, 2) + wasm_i32x4_extract_lane(acc, 3);
+        for (; j < filterSize; j++)
+            val += s[j] * f[j];
+
+        dst[i] = FFMIN(val >> 7, (1 << 15) - 1);
+    }
+}
+
+static void yuv2planeX_8_simd128(const int16_t *filter, int filterSize,
+                                 const int16_t **src, uint8_t *dest, int dstW,
+                                 const uint8_t *dither, int offset)
+{
+    v128_t dither_lo = wasm_i32x4_make(dither[(offset + 0) & 7] << 12,
+                                       dither[(offset + 1) & 7] << 12,
+                                       dither[(offset + 2) & 7] << 12,
+                                       dither[(offset + 3) & 7] << 12);
+    v128_t dither_hi = wasm_i32x4_make(dither[(offset + 4) & 7] << 12,
+                                       dither[(offset + 5) & 7] << 12,
+                                       dither[(offset + 6) & 7] << 12,
+                                       dither[(offset + 7) & 7] << 12);
+    int i, j;
+
+    for (i = 0; i + 8 <= dstW; i += 8) {
+        v128_t lo = dither_lo, hi = dither_hi, v;
+
+        for (j = 0; j < filterSize; j++) {
+            v128_t s = wasm_v128_load(src[j] + i);
+            v128_t f = wasm_i16x8_splat(filter[j]);
+            lo = wasm_i32x4_add(lo, wasm_i32x4_extmul_low_i16x8(s, f));
+            hi = wasm_i32x4_add(hi, wasm_i32x4_extmul_high_i16x8(s, f));
+        }
+        v = wasm_i16x8_narrow_i32x4(wasm_i32x4_shr(lo, 19),
+                                    wasm_i32x4_shr(hi, 19));
+        wasm_v128_store64_lane(dest + i, wasm_u8x16_narrow_i16x8(v, v), 0);
+    }
+    for (; i < dstW; i++) {
+        int val = dither[(i + offset) & 7] << 12;
+
+        for (j = 0; j < filterSize; j++)
+            val += src[j][i] * filter[j];
+        dest[i] = av_clip_uint8(val >> 19);
+    }
+}
+
+static av_always_inline v128_t vfilter_4(const int16_t *filter, int filterSize,
+                                         const int16_t **src, int i)
+{
+    v128_t val = wasm_i32x4_splat(1 << 18);
+    int j;
+
+    for (j = 0; j < filterSize; j++)
+        val = wasm_i32x4_add(val, wasm_i32x4_mul(wasm_i32x4_load16x4(src[j] + i),
+                                                 wasm_i32x4_splat(filter[j])));
+    return wasm_i32x4_shr(val, 19);
+}
+
+/* yuv2rgbx32_X_c for the RGB32 family without alpha. Chroma is clipped to
+ * [0, 255] as the table headroom does, luma is left unclipped as the table
+ * index of the C version is. */
+static void yuv2rgbx32_X_simd128(SwsContext *c, const int16_t *lumFilter,
+                                 const int16_t **lumSrc, int lumFilterSize,
+                                 const int16_t *chrFilter,
+                                 const int16_t **chrUSrc,
+                                 const int16_t **chrVSrc, int chrFilterSize,
+                                 const int16_t **alpSrc, uint8_t *dest,
+                                 int dstW, int y)
+{
+    uint32_t *dst = (uint32_t *)dest;
+    YUV2RGB32Simd128 p;
+    int i, j;
+
+    yuv2rgb32_simd128_setup(c, &p);
+
+    for (i = 0; i + 4 <= (dstW + 1) >> 1; i += 4) {
+        v128_t zero = wasm_i32x4_splat(0), max = wasm_i32x4_splat(255);
+        v128_t y1 = vfilter_4(lumFilter, lumFilterSize, lumSrc, i * 2);
+        v128_t y2 = vfilter_4(lumFilter, lumFilterSize, lumSrc, i * 2 + 4);
+        v128_t u  = vfilter_4(chrFilter, chrFilterSize, chrUSrc, i);
+        v128_t v  = vfilter_4(chrFilter, chrFilterSize, chrVSrc, i);
+        v128_t r, g, b;
+
+        u = wasm_i32x4_max(wasm_i32x4_min(u, max), zero);
+        v = wasm_i32x4_max(wasm_i32x4_min(v, max), zero);
+        yuv2rgb32_simd128_chroma(&p, u, v, &r, &g, &b);
+
+        wasm_v128_store(dst + i * 2,
+                        yuv2rgb32_simd128_pixels(&p, y1,
+                                                 wasm_i32x4_shuffle(r, r, 0, 0, 1, 1),
+                                                 wasm_i32x4_shuffle(g, g, 0, 0, 1, 1),
+                                                 wasm_i32x4_shuffle(b, b, 0, 0, 1, 1)));
+        wasm_v128_store(dst + i * 2 + 4,
+                        yuv2rgb32_simd128_pixels(&p, y2,
+                                                 wasm_i32x4_shuffle(r, r, 2, 2, 3, 3),
+                                                 wasm_i32x4_shuffle(g, g, 2, 2, 3, 3),
+                                                 wasm_i32x4_shuffle(b, b, 2, 2, 3, 3)));
+    }
+    for (; i < (dstW + 1) >> 1; i++) {
+        int Y1 = 1 << 18;
+        int Y2 = 1 << 18;
+        int U  = 1 << 18;
+        int V  = 1 << 18;
+        const uint32_t *r, *g, *b;
+
+        for (j = 0; j < lumFilterSize; j++) {
+            Y1 += lumSrc[j][i * 2]     * lumFilter[j];
+            Y2 += lumSrc[j][i * 2 + 1] * lumFilter[j];
+        }
+        for (j = 0; j < chrFilterSize; j++) {
+            U += chrUSrc[j][i] * chrFilter[j];
+            V += chrVSrc[j][i] * chrFilter[j];
+        }
+        Y1 >>= 19;
+        Y2 >>= 19;
+        U  >>= 19;
+        V  >>= 19;
+
+        r = (const uint32_t *) c->table_rV[V + YUVRGB_TABLE_HEADROOM];
+        g = (const uint32_t *)(c->table_gU[U + YUVRGB_TABLE_HEADROOM] +
+                               c->table_gV[V + YUVRGB_TABLE_HEADROOM]);
+        b = (const uint32_t *) c->table_bU[U + YUVRGB_TABLE_HEADROOM];
+
+        dst[i * 2 + 0] = r[Y1] + g[Y1] + b[Y1];
+        dst[i * 2 + 1] = r[Y2] + g[Y2] + b[Y2];
+    }
+}
+#endif /* HAVE_SIMD128 */
+
+av_cold void ff_sws_init_swscale_wasm(SwsContext *c)
+{
+#if HAVE_SIMD128
+    if (!have_simd128(av_get_cpu_flags()))
+        return;
+
+    if (c->srcBpc == 8 && c->dstBpc <= 14)
+        c->hyScale = c->hcScale = hscale8to15_simd128;
+    if (c->dstBpc == 8)
+        c->yuv2planeX = yuv2planeX_8_simd128;
+    if (yuv2rgb32_simd128_format(c->dstFormat) &&
+        !(c->flags & SWS_FULL_CHR_H_INT) &&
+        !(CONFIG_SWSCALE_ALPHA && c->alpPixBuf) &&
+        yuv2rgb32_simd128_exact(c))
+        c->yuv2packedX = yuv2rgbx32_X_simd128;
+#endif /* HAVE_SIMD128 */
+}
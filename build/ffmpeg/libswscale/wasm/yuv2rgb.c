@@ -0,0 +1,137 @@
+/*
+ * WebAssembly SIMD128 optimized YUV to RGB conversion
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "config.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/wasm/cpu.h"
+
+#if HAVE_SIMD128
+#include "yuv2rgb.h"
+
+static av_always_inline void put_rgb32(const YUV2RGB32Simd128 *p,
+                                       uint32_t *dst, v128_t y,
+                                       v128_t r, v128_t g, v128_t b)
+{
+    wasm_v128_store(dst, yuv2rgb32_simd128_pixels(p, y, r, g, b));
+}
+
+/* Same pixel walk as yuv2rgb_c_32: two lines per chroma line, whole groups
+ * of 8 pixels and then at most one group of 4 and one of 2, with each
+ * chroma sample covering two horizontal pixels. */
+static int yuv2rgb_32_simd128(SwsContext *c, const uint8_t *src[],
+                              int srcStride[], int srcSliceY, int srcSliceH,
+                              uint8_t *dst[], int dstStride[])
+{
+    YUV2RGB32Simd128 p;
+    int y;
+
+    yuv2rgb32_simd128_setup(c, &p);
+
+    if (c->srcFormat == AV_PIX_FMT_YUV422P) {
+        srcStride[1] *= 2;
+        srcStride[2] *= 2;
+    }
+    for (y = 0; y < srcSliceH; y += 2) {
+        uint32_t *dst_1 = (uint32_t *)(dst[0] + (y + srcSliceY)     * dstStride[0]);
+        uint32_t *dst_2 = (uint32_t *)(dst[0] + (y + srcSliceY + 1) * dstStride[0]);
+        const uint8_t *py_1 = src[0] +  y       * srcStride[0];
+        const uint8_t *py_2 = py_1   +            srcStride[0];
+        const uint8_t *pu   = src[1] + (y >> 1) * srcStride[1];
+        const uint8_t *pv   = src[2] + (y >> 1) * srcStride[2];
+        v128_t u, v, r, g, b, y1, y2;
+        int x;
+
+        for (x = 0; x + 8 <= c->dstW; x += 8) {
+            u  = wasm_u32x4_extend_low_u16x8(wasm_u16x8_extend_low_u8x16(
+                     wasm_v128_load32_zero(pu + x / 2)));
+            v  = wasm_u32x4_extend_low_u16x8(wasm_u16x8_extend_low_u8x16(
+                     wasm_v128_load32_zero(pv + x / 2)));
+            y1 = wasm_u16x8_extend_low_u8x16(wasm_v128_load64_zero(py_1 + x));
+            y2 = wasm_u16x8_extend_low_u8x16(wasm_v128_load64_zero(py_2 + x));
+            yuv2rgb32_simd128_chroma(&p, u, v, &r, &g, &b);
+
+            put_rgb32(&p, dst_1 + x, wasm_u32x4_extend_low_u16x8(y1),
+                      wasm_i32x4_shuffle(r, r, 0, 0, 1, 1),
+                      wasm_i32x4_shuffle(g, g, 0, 0, 1, 1),
+                      wasm_i32x4_shuffle(b, b, 0, 0, 1, 1));
+            put_rgb32(&p, dst_2 + x, wasm_u32x4_extend_low_u16x8(y2),
+                      wasm_i32x4_shuffle(r, r, 0, 0, 1, 1),
+                      wasm_i32x4_shuffle(g, g, 0, 0, 1, 1),
+                      wasm_i32x4_shuffle(b, b, 0, 0, 1, 1));
+            put_rgb32(&p, dst_1 + x + 4, wasm_u32x4_extend_high_u16x8(y1),
+                      wasm_i32x4_shuffle(r, r, 2, 2, 3, 3),
+                      wasm_i32x4_shuffle(g, g, 2, 2, 3, 3),
+                      wasm_i32x4_shuffle(b, b, 2, 2, 3, 3));
+            put_rgb32(&p, dst_2 + x + 4, wasm_u32x4_extend_high_u16x8(y2),
+                      wasm_i32x4_shuffle(r, r, 2, 2, 3, 3),
+                      wasm_i32x4_shuffle(g, g, 2, 2, 3, 3),
+                      wasm_i32x4_shuffle(b, b, 2, 2, 3, 3));
+        }
+        if (c->dstW & 4) {
+            u = wasm_i32x4_make(pu[x / 2], pu[x / 2 + 1], 0, 0);
+            v = wasm_i32x4_make(pv[x / 2], pv[x / 2 + 1], 0, 0);
+            yuv2rgb32_simd128_chroma(&p, u, v, &r, &g, &b);
+            r = wasm_i32x4_shuffle(r, r, 0, 0, 1, 1);
+            g = wasm_i32x4_shuffle(g, g, 0, 0, 1, 1);
+            b = wasm_i32x4_shuffle(b, b, 0, 0, 1, 1);
+
+            y1 = wasm_u32x4_extend_low_u16x8(wasm_u16x8_extend_low_u8x16(
+                     wasm_v128_load32_zero(py_1 + x)));
+            y2 = wasm_u32x4_extend_low_u16x8(wasm_u16x8_extend_low_u8x16(
+                     wasm_v128_load32_zero(py_2 + x)));
+            put_rgb32(&p, dst_1 + x, y1, r, g, b);
+            put_rgb32(&p, dst_2 + x, y2, r, g, b);
+            x += 4;
+        }
+        if (c->dstW & 2) {
+            u = wasm_i32x4_splat(pu[x / 2]);
+            v = wasm_i32x4_splat(pv[x / 2]);
+            yuv2rgb32_simd128_chroma(&p, u, v, &r, &g, &b);
+
+            y1 = wasm_i32x4_make(py_1[x], py_1[x + 1], 0, 0);
+            y2 = wasm_i32x4_make(py_2[x], py_2[x + 1], 0, 0);
+            wasm_v128_store64_lane(dst_1 + x,
+                                   yuv2rgb32_simd128_pixels(&p, y1, r, g, b), 0);
+            wasm_v128_store64_lane(dst_2 + x,
+                                   yuv2rgb32_simd128_pixels(&p, y2, r, g, b), 0);
+        }
+    }
+    return srcSliceH;
+}
+#endif /* HAVE_SIMD128 */
+
+av_cold SwsFunc ff_yuv2rgb_init_wasm(SwsContext *c)
+{
+#if HAVE_SIMD128
+    if (!have_simd128(av_get_cpu_flags()))
+        return NULL;
+
+    if (yuv2rgb32_simd128_format(c->dstFormat) &&
+        !(CONFIG_SWSCALE_ALPHA && isALPHA(c->srcFormat)) &&
+        yuv2rgb32_simd128_exact(c))
+        return yuv2rgb_32_simd128;
+#endif /* HAVE_SIMD128 */
+    return NULL;
+}
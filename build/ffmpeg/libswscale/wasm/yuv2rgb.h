@@ -0,0 +1,145 @@
+/*
+ * WebAssembly SIMD128 helpers for YUV to 32-bit RGB conversion
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef SWSCALE_WASM_YUV2RGB_H
+#define SWSCALE_WASM_YUV2RGB_H
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libswscale/swscale_internal.h"
+
+#include <wasm_simd128.h>
+
+/* SIMD128 versions of the table lookups done by the C converters for the
+ * RGB32 family. There is no gather, so instead of reading r[Y] + g[Y] + b[Y]
+ * from the tables of ff_yuv2rgb_c_init_tables() the table entries are
+ * recomputed from the parameters they were built from. This is bit-exact
+ * as long as every lookup stays inside the 1024 entries of a table, which
+ * yuv2rgb32_simd128_exact() checks once for the whole range of U and V. */
+
+typedef struct YUV2RGB32Simd128 {
+    v128_t cy, yb, alpha;
+    v128_t crv, cbu, cgu, cgv;
+    v128_t r_bias, g_bias, b_bias;
+    int rbase, gbase, bbase;
+} YUV2RGB32Simd128;
+
+static inline int yuv2rgb32_simd128_format(enum AVPixelFormat fmt)
+{
+    return fmt == AV_PIX_FMT_RGB32   || fmt == AV_PIX_FMT_BGR32 ||
+           fmt == AV_PIX_FMT_RGB32_1 || fmt == AV_PIX_FMT_BGR32_1;
+}
+
+static inline int64_t yuv2rgb32_chroma_offset(int64_t coeff, int c)
+{
+    return (c * coeff >> 16) - (coeff >> 9);
+}
+
+/* Check that luma values in [0, 255] combined with any U and V index the
+ * tables in range, and that the products fit 32-bit lanes. */
+static inline av_cold int yuv2rgb32_simd128_exact(const SwsContext *c)
+{
+    int64_t yoffs = c->yuv2rgb_table_yoffs;
+    int64_t r0 = yuv2rgb32_chroma_offset(c->yuv2rgb_table_crv, 0);
+    int64_t r1 = yuv2rgb32_chroma_offset(c->yuv2rgb_table_crv, 255);
+    int64_t b0 = yuv2rgb32_chroma_offset(c->yuv2rgb_table_cbu, 0);
+    int64_t b1 = yuv2rgb32_chroma_offset(c->yuv2rgb_table_cbu, 255);
+    int64_t g0 = yuv2rgb32_chroma_offset(c->yuv2rgb_table_cgu, 0);
+    int64_t g1 = yuv2rgb32_chroma_offset(c->yuv2rgb_table_cgu, 255);
+    int64_t h0 = yuv2rgb32_chroma_offset(c->yuv2rgb_table_cgv, 0);
+    int64_t h1 = yuv2rgb32_chroma_offset(c->yuv2rgb_table_cgv, 255);
+    int64_t lo = yoffs + FFMIN3(FFMIN(r0, r1), FFMIN(b0, b1),
+                                FFMIN(g0, g1) + FFMIN(h0, h1));
+    int64_t hi = yoffs + 255 + FFMAX3(FFMAX(r0, r1), FFMAX(b0, b1),
+                                      FFMAX(g0, g1) + FFMAX(h0, h1));
+    int64_t cy = c->yuv2rgb_table_cy, yb = c->yuv2rgb_table_yb + 0x8000;
+    int64_t cmax = FFMAX(FFMAX(FFABS(c->yuv2rgb_table_crv),
+                               FFABS(c->yuv2rgb_table_cbu)),
+                         FFMAX(FFABS(c->yuv2rgb_table_cgu),
+                               FFABS(c->yuv2rgb_table_cgv)));
+
+    return lo >= 0 && hi < 1024 && cy >= 0 && 255 * cmax <= INT32_MAX &&
+           yb >= INT32_MIN && 1023 * cy + yb <= INT32_MAX;
+}
+
+static inline void yuv2rgb32_simd128_setup(const SwsContext *c,
+                                           YUV2RGB32Simd128 *p)
+{
+    enum AVPixelFormat fmt = c->dstFormat;
+    int base  = fmt == AV_PIX_FMT_RGB32_1 || fmt == AV_PIX_FMT_BGR32_1 ? 8 : 0;
+    int isRgb = fmt == AV_PIX_FMT_RGB32   || fmt == AV_PIX_FMT_RGB32_1;
+    int yoffs = c->yuv2rgb_table_yoffs;
+
+    p->rbase  = base + (isRgb ? 16 : 0);
+    p->gbase  = base + 8;
+    p->bbase  = base + (isRgb ? 0 : 16);
+    p->alpha  = wasm_i32x4_splat(255u << ((base + 24) & 31));
+    p->cy     = wasm_i32x4_splat(c->yuv2rgb_table_cy);
+    p->yb     = wasm_i32x4_splat(c->yuv2rgb_table_yb + 0x8000);
+    p->crv    = wasm_i32x4_splat(c->yuv2rgb_table_crv);
+    p->cbu    = wasm_i32x4_splat(c->yuv2rgb_table_cbu);
+    p->cgu    = wasm_i32x4_splat(c->yuv2rgb_table_cgu);
+    p->cgv    = wasm_i32x4_splat(c->yuv2rgb_table_cgv);
+    p->r_bias = wasm_i32x4_splat(yoffs - (c->yuv2rgb_table_crv >> 9));
+    p->b_bias = wasm_i32x4_splat(yoffs - (c->yuv2rgb_table_cbu >> 9));
+    p->g_bias = wasm_i32x4_splat(yoffs - (c->yuv2rgb_table_cgu >> 9) -
+                                         (c->yuv2rgb_table_cgv >> 9));
+}
+
+/* Table offsets for four U and V values in [0, 255]. */
+static av_always_inline void yuv2rgb32_simd128_chroma(const YUV2RGB32Simd128 *p,
+                                                      v128_t u, v128_t v,
+                                                      v128_t *r, v128_t *g,
+                                                      v128_t *b)
+{
+    *r = wasm_i32x4_add(wasm_i32x4_shr(wasm_i32x4_mul(v, p->crv), 16), p->r_bias);
+    *b = wasm_i32x4_add(wasm_i32x4_shr(wasm_i32x4_mul(u, p->cbu), 16), p->b_bias);
+    *g = wasm_i32x4_add(wasm_i32x4_add(wasm_i32x4_shr(wasm_i32x4_mul(u, p->cgu), 16),
+                                       wasm_i32x4_shr(wasm_i32x4_mul(v, p->cgv), 16)),
+                        p->g_bias);
+}
+
+static av_always_inline v128_t yuv2rgb32_simd128_entry(const YUV2RGB32Simd128 *p,
+                                                       v128_t idx)
+{
+    v128_t val = wasm_i32x4_shr(wasm_i32x4_add(wasm_i32x4_mul(idx, p->cy),
+                                               p->yb), 16);
+
+    return wasm_i32x4_max(wasm_i32x4_min(val, wasm_i32x4_splat(255)),
+                          wasm_i32x4_splat(0));
+}
+
+/* Four pixels from four luma values and the table offsets of their chroma. */
+static av_always_inline v128_t yuv2rgb32_simd128_pixels(const YUV2RGB32Simd128 *p,
+                                                        v128_t y, v128_t r,
+                                                        v128_t g, v128_t b)
+{
+    v128_t vr = yuv2rgb32_simd128_entry(p, wasm_i32x4_add(y, r));
+    v128_t vg = yuv2rgb32_simd128_entry(p, wasm_i32x4_add(y, g));
+    v128_t vb = yuv2rgb32_simd128_entry(p, wasm_i32x4_add(y, b));
+
+    return wasm_v128_or(wasm_v128_or(wasm_i32x4_shl(vr, p->rbase),
+                                     wasm_i32x4_shl(vg, p->gbase)),
+                        wasm_v128_or(wasm_i32x4_shl(vb, p->bbase), p->alpha));
+}
+
+#endif /* SWSCALE_WASM_YUV2RGB_H */
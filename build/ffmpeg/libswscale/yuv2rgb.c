@@ -603,6 +603,8 @@ SwsFunc ff_yuv2rgb_get_func_ptr(SwsContext *c)
 
     if (ARCH_PPC)
         t = ff_yuv2rgb_init_ppc(c);
+    if (ARCH_WASM)
+        t = ff_yuv2rgb_init_wasm(c);
     if (ARCH_X86)
         t = ff_yuv2rgb_init_x86(c);
 
@@ -769,6 +771,14 @@ av_cold int ff_yuv2rgb_c_init_tables(SwsContext *c, const int inv_table[4],
     cgu = ((cgu << 16) + 0x8000) / FFMAX(cy, 1);
     cgv = ((cgv << 16) + 0x8000) / FFMAX(cy, 1);
 
+    c->yuv2rgb_table_cy    = cy;
+    c->yuv2rgb_table_yb    = -(384 << 16) - oy;
+    c->yuv2rgb_table_yoffs = yoffs;
+    c->yuv2rgb_table_crv   = crv;
+    c->yuv2rgb_table_cbu   = cbu;
+    c->yuv2rgb_table_cgu   = cgu;
+    c->yuv2rgb_table_cgv   = cgv;
+
     av_freep(&c->yuvTable);
 
     switch (bpp) {
@@ -19,5 +19,17 @@ fate-rangecoder: CMD = run libavcodec/rangecoder-test
 fate-rangecoder: CMP = null
 fate-rangecoder: REF = /dev/null
 
+FATE_LIBAVCODEC-$(CONFIG_VP8_DECODER) += fate-vp8dsp
+fate-vp8dsp: libavcodec/vp8dsp-test$(EXESUF)
+fate-vp8dsp: CMD = run libavcodec/vp8dsp-test
+fate-vp8dsp: CMP = null
+fate-vp8dsp: REF = /dev/null
+
+FATE_LIBAVCODEC-$(CONFIG_VP9_DECODER) += fate-vp9dsp
+fate-vp9dsp: libavcodec/vp9dsp-test$(EXESUF)
+fate-vp9dsp: CMD = run libavcodec/vp9dsp-test
+fate-vp9dsp: CMP = null
+fate-vp9dsp: REF = /dev/null
+
 FATE-$(CONFIG_AVCODEC) += $(FATE_LIBAVCODEC-yes)
 fate-libavcodec: $(FATE_LIBAVCODEC-yes)
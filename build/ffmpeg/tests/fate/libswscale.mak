@@ -0,0 +1,8 @@
+FATE_LIBSWSCALE += fate-sws-scalefuncs
+fate-sws-scalefuncs: libswscale/scalefuncs-test$(EXESUF)
+fate-sws-scalefuncs: CMD = run libswscale/scalefuncs-test
+fate-sws-scalefuncs: CMP = null
+fate-sws-scalefuncs: REF = /dev/null
+
+FATE-$(CONFIG_SWSCALE) += $(FATE_LIBSWSCALE)
+fate-libswscale: $(FATE_LIBSWSCALE)
@@ -0,0 +1,95 @@
+/*
+JavaScript side of FFmpeg's jsstream: protocol (libavformat/jsstream.c), linked
+in with --js-library.
+
+"jsstream:name" opens Module['streams'][name], an object with:
+  size               total size in bytes, leave out if unknown (not seekable)
+  read(pos, length)  return a Uint8Array of at most length bytes from pos,
+                     an empty one at the end of the stream
+  write(data, pos)   receive a chunk of output that belongs at pos; data is a
+                     copy and may be kept
+  close()            optional
+
+Outputs that have no stream registered are passed to
+Module['onOutputChunk'](name, data, pos) if it is set.
+*/
+
+mergeInto(LibraryManager.library, {
+  $JSStream: {
+    handles: []
+  },
+
+  ff_jsstream_open__deps: ['$JSStream'],
+  ff_jsstream_open__proxy: 'sync',
+  ff_jsstream_open: function(name, flags) {
+    name = UTF8ToString(name);
+    var streams = Module['streams'] || {};
+    var stream = streams[name];
+    /* AVIO_FLAG_WRITE */
+    if (!stream && (flags & 2) && Module['onOutputChunk']) {
+      stream = {
+        write: function(data, pos) {
+          Module['onOutputChunk'](name, data, pos);
+        }
+      };
+    }
+    if (!stream) {
+      return -1;
+    }
+    /* reuse the slot of a closed stream, so that an instance running many
+       jobs only keeps as many slots as it has streams open at once */
+    var handle = JSStream.handles.indexOf(null);
+    if (handle < 0) {
+      handle = JSStream.handles.length;
+    }
+    JSStream.handles[handle] = stream;
+    return handle;
+  },
+
+  ff_jsstream_read__deps: ['$JSStream'],
+  ff_jsstream_read__proxy: 'sync',
+  ff_jsstream_read: function(handle, buf, size, pos) {
+    var stream = JSStream.handles[handle];
+    if (!stream.read) {
+      return -1;
+    }
+    var data = stream.read(pos, size);
+    if (!data) {
+      return 0;
+    }
+    if (data.length > size) {
+      data = data.subarray(0, size);
+    }
+    HEAPU8.set(data, buf);
+    return data.length;
+  },
+
+  ff_jsstream_write__deps: ['$JSStream'],
+  ff_jsstream_write__proxy: 'sync',
+  ff_jsstream_write: function(handle, buf, size, pos) {
+    var stream = JSStream.handles[handle];
+    if (!stream.write) {
+      return -1;
+    }
+    /* the heap buffer is reused by aviobuf for the next chunk */
+    stream.write(HEAPU8.slice(buf, buf + size), pos);
+    return size;
+  },
+
+  ff_jsstream_size__deps: ['$JSStream'],
+  ff_jsstream_size__proxy: 'sync',
+  ff_jsstream_size: function(handle) {
+    var stream = JSStream.handles[handle];
+    return typeof(stream.size) === 'number' ? stream.size : -1;
+  },
+
+  ff_jsstream_close__deps: ['$JSStream'],
+  ff_jsstream_close__proxy: 'sync',
+  ff_jsstream_close: function(handle) {
+    var stream = JSStream.handles[handle];
+    JSStream.handles[handle] = null;
+    if (stream && stream.close) {
+      stream.close();
+    }
+  }
+});
@@ -1,7 +1,243 @@
 
-  return Module['return'];
+  if (isNode) {
+    return;
+  }
+
+  function allocateString(str) {
+    var length = lengthBytesUTF8(str) + 1;
+    var ptr = _malloc(length);
+    stringToUTF8(str, ptr, length);
+    return ptr;
+  }
+
+  /* -stats_json writes one JSON object per line, and a line can be split
+     over several writes.  The memory stats are counted per job, from when
+     it starts: current and peak are the bytes av_malloc()ed since then less
+     those freed (never below 0, as the job can free blocks an earlier job
+     allocated), allocs the number of allocations.  heap is added to them:
+     the size of the whole module heap, which also holds what libvpx and
+     libx264 allocate themselves.  The heap only grows, so this is the
+     largest footprint of any job run on the instance so far. */
+  function getStatsStream(callback) {
+    var pending = '';
+    return {
+      write: function(data) {
+        pending += String.fromCharCode.apply(null, data);
+        var lines = pending.split('\n');
+        pending = lines.pop();
+        lines.forEach(function(line) {
+          var stats = JSON.parse(line);
+          stats.memory.heap = HEAPU8.length;
+          callback(stats);
+        });
+      }
+    };
+  }
+
+  function clearDirectory(path) {
+    FS.readdir(path).forEach(function(name) {
+      if (name !== '.' && name !== '..') {
+        FS.unlink(path + '/' + name);
+      }
+    });
+  }
+
+  /* Options of a single job, defaulting to the ones the instance was
+     created with. */
+  function getJobOptions(opts) {
+    var result = {};
+    ['fragmented', 'threads', 'onOutputChunk', 'TOTAL_MEMORY'].forEach(function(name) {
+      result[name] = opts && name in opts ? opts[name] : Module[name];
+    });
+    return result;
+  }
+
+  /* The heap never shrinks, so TOTAL_MEMORY of a job only makes sure that
+     the heap has at least that size before the job starts, instead of
+     growing it step by step while the job runs.  Returns false if the heap
+     cannot grow that far (past the MAXIMUM_MEMORY of the build, or the
+     browser refused the memory). */
+  function reserveHeap(size) {
+    if (size > HEAPU8.length) {
+      var ptr = _malloc(size - HEAPU8.length);
+      if (!ptr) {
+        return false;
+      }
+      _free(ptr);
+    }
+    return HEAPU8.length >= size;
+  }
+
+  /* Run one command line and return the files it wrote to the output
+     directory.  files are the inputs for this job only: { name, data } is
+     written to MEMFS, { name, blob } is read through jsstream:name.  Both
+     are removed again once the job is done, as are the outputs.
+     opts can set fragmented, threads, onOutputChunk and TOTAL_MEMORY for
+     this job only; the values passed to ffmpeg_instance() apply otherwise.
+     instance.onStats, if set, is called with the job's stage timings and
+     memory use (see getStatsStream) every instance.statsPeriod seconds and
+     when it ends. */
+  function run(args, files, opts) {
+    if (!runtimeReady) {
+      throw new Error("ffmpeg_instance: run() called before instance.ready()");
+    }
+    args = args || [];
+    files = files || [];
+    opts = getJobOptions(opts);
+    if (opts.threads > 1 &&
+        getPoolSize(args, opts.threads, 1) > (Module['pthreadPoolSize'] || 1)) {
+      Module['printErr']("This job needs " + getPoolSize(args, opts.threads, 1) +
+                         " threads but the instance was created with " +
+                         (Module['pthreadPoolSize'] || 1) + "; pass a larger threads, " +
+                         "maxInputs or pthreadPoolSize to ffmpeg_instance()");
+      instance.exitCode = 1;
+      return [];
+    }
+    if (opts.TOTAL_MEMORY && !reserveHeap(opts.TOTAL_MEMORY)) {
+      Module['printErr']("This job asked for a heap of " + opts.TOTAL_MEMORY +
+                         " bytes (TOTAL_MEMORY) but the heap could not grow past " +
+                         HEAPU8.length + " bytes");
+      instance.exitCode = 1;
+      return [];
+    }
+    args = getArguments(args, opts);
+
+    Module['streams'] = Module['streams'] || {};
+    if (instance.onStats) {
+      Module['streams'][STATS_STREAM] = getStatsStream(instance.onStats);
+      args = ['-stats_json', 'jsstream:' + STATS_STREAM,
+              '-stats_json_period', String(instance.statsPeriod)].concat(args);
+    }
+    files.forEach(function(file) {
+      if (file.blob) {
+        Module['streams'][file.name] = getBlobStream(file.blob);
+      } else if (file.data) {
+        FS.createDataFile('/', file.name, file.data, true, true);
+      }
+    });
+
+    args.unshift('ffmpeg');
+    var argv = _malloc(args.length * 4);
+    args.forEach(function(arg, i) {
+      HEAP32[(argv >> 2) + i] = allocateString(arg);
+    });
+
+    var onOutputChunk = Module['onOutputChunk'];
+    Module['onOutputChunk'] = opts.onOutputChunk;
+    instance.exitCode = _ffmpeg_run_job(args.length, argv);
+    Module['onOutputChunk'] = onOutputChunk;
+
+    for (var i = 0; i < args.length; i++) {
+      _free(HEAP32[(argv >> 2) + i]);
+    }
+    _free(argv);
+
+    var buffers = getAllBuffers(FS.analyzePath(Module['outputDirectory']));
+    clearDirectory(Module['outputDirectory']);
+    delete Module['streams'][STATS_STREAM];
+    files.forEach(function(file) {
+      if (file.blob) {
+        delete Module['streams'][file.name];
+      } else if (file.data) {
+        FS.unlink('/' + file.name);
+      }
+    });
+    return buffers;
+  }
+
+  /* Keyframe thumbnails of file ({ name, data } or { name, blob }) without
+     running a full conversion: up to count { time, data } objects, where data
+     is an ArrayBuffer of width * height RGBA pixels and time is in seconds.
+     Fewer are returned if the file has fewer keyframes.  As with run(),
+     instance.exitCode is 0 on success; on failure it is 1, the error is
+     printed and nothing is returned. */
+  function thumbnails(file, count, width, height) {
+    if (!runtimeReady) {
+      throw new Error("ffmpeg_instance: thumbnails() called before instance.ready()");
+    }
+    var path = file.blob ? 'jsstream:' + file.name : '/' + file.name;
+    if (file.blob) {
+      Module['streams'] = Module['streams'] || {};
+      Module['streams'][file.name] = getBlobStream(file.blob);
+    } else {
+      FS.createDataFile('/', file.name, file.data, true, true);
+    }
+
+    var size = width * height * 4;
+    /* _malloc takes a 32-bit size */
+    var dst = count * size < 0x80000000 ? _malloc(count * size) : 0;
+    var times = _malloc(count * 8);
+    var result = [];
+
+    instance.exitCode = 0;
+    if (!dst || !times) {
+      Module['printErr']("Not enough memory for " + count + " thumbnails of " +
+                         width + "x" + height);
+      instance.exitCode = 1;
+    } else {
+      var filename = allocateString(path);
+      var n = _ffmpeg_thumbnails(filename, count, width, height, dst, times);
+      _free(filename);
+      if (n < 0) {
+        Module['printErr']("Could not get thumbnails of " + file.name + " (error " + n + ")");
+        instance.exitCode = 1;
+      }
+      for (var i = 0; i < n; i++) {
+        result.push({
+          time: HEAPF64[(times >> 3) + i],
+          data: HEAPU8.slice(dst + i * size, dst + (i + 1) * size).buffer
+        });
+      }
+    }
+
+    _free(times);
+    _free(dst);
+    if (file.blob) {
+      delete Module['streams'][file.name];
+    } else {
+      FS.unlink('/' + file.name);
+    }
+    return result;
+  }
+
+  /* callback(instance) is called once the runtime has started, right away
+     if it already has.  Only the threaded build needs to wait for it. */
+  function ready(callback) {
+    if (runtimeReady) {
+      callback(instance);
+    } else {
+      readyCallbacks.push(function() {
+        callback(instance);
+      });
+    }
+  }
+
+  var STATS_STREAM = 'ffmpeg-stats';
+
+  var instance = {
+    run: run,
+    thumbnails: thumbnails,
+    ready: ready,
+    onStats: Module['onStats'] || null,
+    statsPeriod: Module['statsPeriod'] || 1,
+    exitCode: 0
+  };
+  return instance;
+}
+
+/* Single conversion on a fresh instance.  Workers that convert more than one
+   file should keep an ffmpeg_instance() around and call run() on it instead,
+   which skips the module setup on every job.  The threaded build starts
+   asynchronously and has to go through ffmpeg_instance().ready(). */
+function ffmpeg_run(opts) {
+  var files = (opts['files'] || []).slice();
+  /* fileData / fileName is deprecated - please use file.name and file.data instead */
+  if (opts['fileData']) {
+    files.unshift({ name: opts['fileName'], data: opts['fileData'] });
+  }
+  return ffmpeg_instance(opts).run(opts['arguments'], files);
 }
 
 if (typeof(exports) !== 'undefined') {
-  ffmpeg_run.call(this);
-}
\ No newline at end of file
+  ffmpeg_instance.call(this);
+}
@@ -8,7 +8,7 @@ The source code used to build this file can be obtained at https://github.com/bg
 and in zip form at https://github.com/bgrins/videoconverter.js/archive/master.zip
 */
 
-function ffmpeg_run(opts) {
+function ffmpeg_instance(opts) {
   var isNode = typeof(exports) !== 'undefined';
   if (!isNode) {
     var Module = {
@@ -17,26 +17,58 @@ function ffmpeg_run(opts) {
     for (var i in opts) {
       Module[i] = opts[i];
     }
-    var outputFilePath = Module['arguments'][Module['arguments'].length - 1];
-    if (Module['arguments'].length > 2 && outputFilePath && outputFilePath.indexOf(".") > -1) {
-      Module['arguments'][Module['arguments'].length - 1] = "output/" + outputFilePath;
+    /* main() is not called on load.  Every job goes through run() (see
+       ffmpeg_post.js), which calls ffmpeg_run_job() on the same module, so
+       the heap and the registered codecs are reused between jobs. */
+    Module['noInitialRun'] = true;
+    Module['noExitRuntime'] = true;
+    /* threads only has an effect with the threaded build (ffmpeg-threaded.js).
+       The worker pool is created with the module, so it is sized here for
+       the arguments passed on creation and for at least maxInputs inputs
+       (1 by default).  run() refuses jobs that need more workers than that,
+       since they would wait forever for a thread. */
+    if (Module['threads'] > 1 && !Module['pthreadPoolSize']) {
+      Module['pthreadPoolSize'] = getPoolSize(Module['arguments'] || [], Module['threads'],
+                                              Module['maxInputs'] || 1);
     }
+    /* The threaded build only starts the runtime once its worker pool has
+       loaded, which happens asynchronously, so jobs have to wait for
+       instance.ready() (see ffmpeg_post.js).  The other builds are ready as
+       soon as ffmpeg_instance() returns. */
+    var runtimeReady = false;
+    var readyCallbacks = [];
+    var onRuntimeInitialized = Module['onRuntimeInitialized'];
+    Module['onRuntimeInitialized'] = function() {
+      if (onRuntimeInitialized) {
+        onRuntimeInitialized();
+      }
+      runtimeReady = true;
+      readyCallbacks.splice(0).forEach(function(callback) {
+        callback();
+      });
+    };
     Module['preRun'] = function() {
       FS.createFolder('/', Module['outputDirectory'], true, true);
-      /* fileData / fileName is deprecated - please use file.name and file.data instead */
-      if (Module['fileData']) {
-        FS.createDataFile('/', Module['fileName'], Module['fileData'], true, true);
+    };
+    function getArguments(args, opts) {
+      args = args.slice();
+      var outputFilePath = args[args.length - 1];
+      if (args.length > 2 && outputFilePath && outputFilePath.indexOf(".") > -1 &&
+          outputFilePath.indexOf("jsstream:") !== 0) {
+        args[args.length - 1] = Module['outputDirectory'] + "/" + outputFilePath;
       }
-      if (Module['files']) {
-        Module['files'].forEach(function(file) {
-          FS.createDataFile('/', file.name, file.data, true, true);
-        });
+      /* fragmented MP4 writes an empty moov first and then a moof/mdat pair
+         per keyframe, so the output can be used while it is being written
+         (e.g. from jsstream: chunks) instead of only once the moov is known */
+      if (opts.fragmented && args.indexOf("-movflags") === -1 &&
+          /\.(mp4|m4v|m4a|mov|ismv)$/i.test(outputFilePath)) {
+        args.splice(args.length - 1, 0, "-movflags", "frag_keyframe+empty_moov");
       }
-    };
-    Module['postRun'] = function() {
-      var handle = FS.analyzePath(Module['outputDirectory']);
-      Module['return'] = getAllBuffers(handle);
-    };
+      if (opts.threads > 1) {
+        args = getThreadedArguments(args, opts.threads);
+      }
+      return args;
+    }
     function getAllBuffers(result) {
       var buffers = [];
       if (result && result.object && result.object.contents) {
@@ -51,4 +83,90 @@ function ffmpeg_run(opts) {
       }
       return buffers;
     }
+    function getBlobStream(blob) {
+      var reader = new FileReaderSync();
+      return {
+        size: blob.size,
+        read: function(pos, length) {
+          return new Uint8Array(reader.readAsArrayBuffer(blob.slice(pos, pos + length)));
+        }
+      };
+    }
+    /* ffmpeg options that take no value, so that output file names can be
+       told apart from option values.  Boolean options also come as -noname. */
+    function isFlagOption(arg) {
+      var flags = ["y", "n", "accurate_seek", "benchmark", "benchmark_all",
+        "stdin", "dump", "hex", "re", "copyts", "shortest", "xerror", "copyinkf",
+        "stats", "debug_ts", "intra", "vn", "sameq", "same_quant", "deinterlace",
+        "psnr", "vstats", "qphist", "force_fps", "an", "sn", "dn",
+        "fix_sub_duration", "isync", "override_ffserver", "hide_banner"];
+      var name = arg.slice(1).split(":")[0];
+      return flags.indexOf(name) > -1 ||
+             (name.indexOf("no") === 0 && flags.indexOf(name.slice(2)) > -1);
+    }
+    /* The outputs are the arguments after the last input that are neither
+       options nor option values.  Returns their indexes and the -threads
+       given among each one's options, or null if there is none. */
+    function getOutputs(args) {
+      var lastInput = args.lastIndexOf("-i");
+      var threads = null;
+      var outputs = [];
+      for (var i = lastInput > -1 ? lastInput + 2 : 0; i < args.length; i++) {
+        if (args[i] === "-threads") {
+          threads = parseInt(args[i + 1], 10) || 1;
+        }
+        if (args[i].charAt(0) === "-" && args[i].length > 1) {
+          if (!isFlagOption(args[i])) {
+            i++;
+          }
+        } else {
+          outputs.push({ index: i, threads: threads });
+          threads = null;
+        }
+      }
+      return outputs;
+    }
+    /* Decoders produce the same frames at any thread count, so every input
+       gets the requested number of threads.  Encoders like libx264 change
+       their bitstream with the thread count, so every output stays single
+       threaded unless a -threads option is passed among its own options. */
+    function getThreadedArguments(args, threads) {
+      var result = [];
+      var lastInput = args.lastIndexOf("-i");
+      var outputs = getOutputs(args).filter(function(output) {
+        return output.threads === null;
+      }).map(function(output) {
+        return output.index;
+      });
+      var inputThreads = false;
+      for (var i = 0; i < args.length; i++) {
+        if (args[i] === "-threads" && i < lastInput) {
+          inputThreads = true;
+        }
+        if (args[i] === "-i") {
+          if (!inputThreads) {
+            result.push("-threads", String(threads));
+          }
+          inputThreads = false;
+        }
+        if (outputs.indexOf(i) > -1) {
+          result.push("-threads", "1");
+        }
+        result.push(args[i]);
+      }
+      return result;
+    }
+    /* one worker per decoder thread and input thread (ffmpeg.c reads
+       each input on its own thread when there are several), plus the
+       threads of every output */
+    function getPoolSize(args, threads, minInputs) {
+      var inputs = args.filter(function(arg) {
+        return arg === "-i";
+      }).length;
+      var outputThreads = 0;
+      getOutputs(args).forEach(function(output) {
+        outputThreads += output.threads === null ? 1 : output.threads;
+      });
+      return Math.max(inputs, minInputs) * (threads + 1) + Math.max(outputThreads, 1);
+    }
   }
\ No newline at end of file
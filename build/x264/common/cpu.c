@@ -85,6 +85,8 @@ const x264_cpu_name_t x264_cpu_names[] =
     {"UnalignedStack",  X264_CPU_STACK_MOD4},
 #elif ARCH_PPC
     {"Altivec",         X264_CPU_ALTIVEC},
+#elif ARCH_WASM
+    {"SIMD128",         X264_CPU_SIMD128},
 #elif ARCH_ARM
     {"ARMv6",           X264_CPU_ARMV6},
     {"NEON",            X264_CPU_NEON},
@@ -364,6 +366,20 @@ uint32_t x264_cpu_detect( void )
 }
 #endif
 
+#elif ARCH_WASM
+
+/* WebAssembly has no way to probe for features at run time: a module using
+ * SIMD instructions fails to validate on engines that lack them, so support
+ * is decided when the module is compiled. */
+uint32_t x264_cpu_detect( void )
+{
+#if HAVE_SIMD128
+    return X264_CPU_SIMD128;
+#else
+    return 0;
+#endif
+}
+
 #elif ARCH_ARM
 
 void x264_cpu_neon_test( void );
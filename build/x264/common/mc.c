@@ -32,6 +32,9 @@
 #if ARCH_PPC
 #include "ppc/mc.h"
 #endif
+#if ARCH_WASM
+#include "wasm/mc.h"
+#endif
 #if ARCH_ARM
 #include "arm/mc.h"
 #endif
@@ -638,6 +641,10 @@ void x264_mc_init( int cpu, x264_mc_functions_t *pf, int cpu_independent )
     if( cpu&X264_CPU_ALTIVEC )
         x264_mc_altivec_init( pf );
 #endif
+#if HAVE_SIMD128
+    if( cpu&X264_CPU_SIMD128 )
+        x264_mc_simd128_init( pf );
+#endif
 #if HAVE_ARMV6
     x264_mc_init_arm( cpu, pf );
 #endif
@@ -34,6 +34,9 @@
 #if ARCH_PPC
 #   include "ppc/pixel.h"
 #endif
+#if ARCH_WASM
+#   include "wasm/pixel.h"
+#endif
 #if ARCH_ARM
 #   include "arm/pixel.h"
 #   include "arm/predict.h"
@@ -1410,6 +1413,12 @@ void x264_pixel_init( int cpu, x264_pixel_function_t *pixf )
         x264_pixel_altivec_init( pixf );
     }
 #endif
+#if HAVE_SIMD128
+    if( cpu&X264_CPU_SIMD128 )
+    {
+        x264_pixel_simd128_init( pixf );
+    }
+#endif
 #if !HIGH_BIT_DEPTH
 #if ARCH_UltraSPARC
     INIT4( sad, _vis );
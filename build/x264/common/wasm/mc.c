@@ -0,0 +1,179 @@
+/*****************************************************************************
+ * mc.c: wasm simd128 motion compensation
+ *****************************************************************************
+ * Copyright (C) 2003-2014 x264 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at licensing@x264.com.
+ *****************************************************************************/
+
+#include "common/common.h"
+#include "mc.h"
+
+#include <wasm_simd128.h>
+
+#if !HIGH_BIT_DEPTH
+/* Implicit weighted bipred uses weights outside [0,64], so the products are
+ * accumulated in 32 bits to match pixel_avg_weight_wxh in common/mc.c. */
+static ALWAYS_INLINE v128_t avg_weight_8px( uint8_t *src1, uint8_t *src2, v128_t w1, v128_t w2 )
+{
+    v128_t s1 = wasm_u16x8_load8x8( src1 );
+    v128_t s2 = wasm_u16x8_load8x8( src2 );
+    v128_t rnd = wasm_i32x4_splat( 1<<5 );
+    v128_t lo = wasm_i32x4_add( wasm_i32x4_add( wasm_i32x4_extmul_low_i16x8( s1, w1 ),
+                                                wasm_i32x4_extmul_low_i16x8( s2, w2 ) ), rnd );
+    v128_t hi = wasm_i32x4_add( wasm_i32x4_add( wasm_i32x4_extmul_high_i16x8( s1, w1 ),
+                                                wasm_i32x4_extmul_high_i16x8( s2, w2 ) ), rnd );
+    return wasm_i16x8_narrow_i32x4( wasm_i32x4_shr( lo, 6 ), wasm_i32x4_shr( hi, 6 ) );
+}
+
+#define PIXEL_AVG_SIMD128( width, height )\
+static void pixel_avg_##width##x##height##_simd128( uint8_t *dst,  intptr_t i_dst,\
+                                                     uint8_t *src1, intptr_t i_src1,\
+                                                     uint8_t *src2, intptr_t i_src2, int i_weight )\
+{\
+    if( i_weight == 32 )\
+    {\
+        for( int y = 0; y < height; y++, dst += i_dst, src1 += i_src1, src2 += i_src2 )\
+        {\
+            if( width == 16 )\
+                wasm_v128_store( dst, wasm_u8x16_avgr( wasm_v128_load( src1 ), wasm_v128_load( src2 ) ) );\
+            else\
+                wasm_v128_store64_lane( dst, wasm_u8x16_avgr( wasm_v128_load64_zero( src1 ),\
+                                                              wasm_v128_load64_zero( src2 ) ), 0 );\
+        }\
+    }\
+    else\
+    {\
+        v128_t w1 = wasm_i16x8_splat( i_weight );\
+        v128_t w2 = wasm_i16x8_splat( 64 - i_weight );\
+        for( int y = 0; y < height; y++, dst += i_dst, src1 += i_src1, src2 += i_src2 )\
+        {\
+            v128_t lo = avg_weight_8px( src1, src2, w1, w2 );\
+            if( width == 16 )\
+            {\
+                v128_t hi = avg_weight_8px( src1+8, src2+8, w1, w2 );\
+                wasm_v128_store( dst, wasm_u8x16_narrow_i16x8( lo, hi ) );\
+            }\
+            else\
+                wasm_v128_store64_lane( dst, wasm_u8x16_narrow_i16x8( lo, lo ), 0 );\
+        }\
+    }\
+}
+
+PIXEL_AVG_SIMD128( 16, 16 )
+PIXEL_AVG_SIMD128( 16, 8 )
+PIXEL_AVG_SIMD128( 8, 16 )
+PIXEL_AVG_SIMD128( 8, 8 )
+PIXEL_AVG_SIMD128( 8, 4 )
+
+/* TAPFILTER of 8-bit input stays within [-2550, 10710] and fits in 16 bits */
+static ALWAYS_INLINE v128_t tapfilter_u8( uint8_t *pix, intptr_t d )
+{
+    v128_t a = wasm_i16x8_add( wasm_u16x8_load8x8( pix-2*d ), wasm_u16x8_load8x8( pix+3*d ) );
+    v128_t b = wasm_i16x8_add( wasm_u16x8_load8x8( pix-1*d ), wasm_u16x8_load8x8( pix+2*d ) );
+    v128_t c = wasm_i16x8_add( wasm_u16x8_load8x8( pix ),     wasm_u16x8_load8x8( pix+1*d ) );
+    return wasm_i16x8_add( wasm_i16x8_sub( a, wasm_i16x8_mul( b, wasm_i16x8_splat( 5 ) ) ),
+                           wasm_i16x8_mul( c, wasm_i16x8_splat( 20 ) ) );
+}
+
+/* the second pass runs on intermediates of up to 10710, so widen to 32 bits */
+static ALWAYS_INLINE v128_t tapfilter_i16_half( v128_t a, v128_t b, v128_t c, int high )
+{
+    if( high )
+    {
+        a = wasm_i32x4_extend_high_i16x8( a );
+        b = wasm_i32x4_extend_high_i16x8( b );
+        c = wasm_i32x4_extend_high_i16x8( c );
+    }
+    else
+    {
+        a = wasm_i32x4_extend_low_i16x8( a );
+        b = wasm_i32x4_extend_low_i16x8( b );
+        c = wasm_i32x4_extend_low_i16x8( c );
+    }
+    return wasm_i32x4_add( wasm_i32x4_sub( a, wasm_i32x4_mul( b, wasm_i32x4_splat( 5 ) ) ),
+                           wasm_i32x4_mul( c, wasm_i32x4_splat( 20 ) ) );
+}
+
+static ALWAYS_INLINE v128_t round_shift5( v128_t v )
+{
+    v = wasm_i16x8_shr( wasm_i16x8_add( v, wasm_i16x8_splat( 16 ) ), 5 );
+    return wasm_u8x16_narrow_i16x8( v, v );
+}
+
+#define TAPFILTER(pix, d) ((pix)[x-2*d] + (pix)[x+3*d] - 5*((pix)[x-d] + (pix)[x+2*d]) + 20*((pix)[x] + (pix)[x+d]))
+static void hpel_filter_simd128( uint8_t *dsth, uint8_t *dstv, uint8_t *dstc, uint8_t *src,
+                                 intptr_t stride, int width, int height, int16_t *buf )
+{
+    for( int y = 0; y < height; y++ )
+    {
+        int x = -2;
+        for( ; x+8 <= width+3; x += 8 )
+        {
+            v128_t v = tapfilter_u8( src+x, stride );
+            wasm_v128_store64_lane( dstv+x, round_shift5( v ), 0 );
+            wasm_v128_store( buf+x+2, v );
+        }
+        for( ; x < width+3; x++ )
+        {
+            int v = TAPFILTER(src,stride);
+            dstv[x] = x264_clip_pixel( (v + 16) >> 5 );
+            buf[x+2] = v;
+        }
+
+        x = 0;
+        for( ; x+8 <= width; x += 8 )
+        {
+            int16_t *b = buf+2+x;
+            v128_t a = wasm_i16x8_add( wasm_v128_load( b-2 ), wasm_v128_load( b+3 ) );
+            v128_t m = wasm_i16x8_add( wasm_v128_load( b-1 ), wasm_v128_load( b+2 ) );
+            v128_t c = wasm_i16x8_add( wasm_v128_load( b ),   wasm_v128_load( b+1 ) );
+            v128_t lo = wasm_i32x4_shr( wasm_i32x4_add( tapfilter_i16_half( a, m, c, 0 ), wasm_i32x4_splat( 512 ) ), 10 );
+            v128_t hi = wasm_i32x4_shr( wasm_i32x4_add( tapfilter_i16_half( a, m, c, 1 ), wasm_i32x4_splat( 512 ) ), 10 );
+            v128_t r = wasm_i16x8_narrow_i32x4( lo, hi );
+            wasm_v128_store64_lane( dstc+x, wasm_u8x16_narrow_i16x8( r, r ), 0 );
+        }
+        for( ; x < width; x++ )
+            dstc[x] = x264_clip_pixel( (TAPFILTER(buf+2,1) + 512) >> 10 );
+
+        x = 0;
+        for( ; x+8 <= width; x += 8 )
+            wasm_v128_store64_lane( dsth+x, round_shift5( tapfilter_u8( src+x, 1 ) ), 0 );
+        for( ; x < width; x++ )
+            dsth[x] = x264_clip_pixel( (TAPFILTER(src,1) + 16) >> 5 );
+
+        dsth += stride;
+        dstv += stride;
+        dstc += stride;
+        src += stride;
+    }
+}
+#endif // !HIGH_BIT_DEPTH
+
+void x264_mc_simd128_init( x264_mc_functions_t *pf )
+{
+#if !HIGH_BIT_DEPTH
+    pf->avg[PIXEL_16x16] = pixel_avg_16x16_simd128;
+    pf->avg[PIXEL_16x8]  = pixel_avg_16x8_simd128;
+    pf->avg[PIXEL_8x16]  = pixel_avg_8x16_simd128;
+    pf->avg[PIXEL_8x8]   = pixel_avg_8x8_simd128;
+    pf->avg[PIXEL_8x4]   = pixel_avg_8x4_simd128;
+
+    pf->hpel_filter = hpel_filter_simd128;
+#endif // !HIGH_BIT_DEPTH
+}
@@ -0,0 +1,222 @@
+/*****************************************************************************
+ * pixel.c: wasm simd128 pixel metrics
+ *****************************************************************************
+ * Copyright (C) 2003-2014 x264 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at licensing@x264.com.
+ *****************************************************************************/
+
+#include "common/common.h"
+#include "pixel.h"
+
+#include <wasm_simd128.h>
+
+#if !HIGH_BIT_DEPTH
+/***********************************************************************
+ * SAD routines
+ **********************************************************************/
+
+/* |a - b| of unsigned bytes, summed pairwise into 16-bit lanes */
+static ALWAYS_INLINE v128_t absdiff_u8( v128_t a, v128_t b )
+{
+    v128_t d = wasm_v128_or( wasm_u8x16_sub_sat( a, b ), wasm_u8x16_sub_sat( b, a ) );
+    return wasm_u16x8_extadd_pairwise_u8x16( d );
+}
+
+static ALWAYS_INLINE int hsum_u16( v128_t v )
+{
+    v = wasm_u32x4_extadd_pairwise_u16x8( v );
+    return wasm_i32x4_extract_lane( v, 0 ) + wasm_i32x4_extract_lane( v, 1 )
+         + wasm_i32x4_extract_lane( v, 2 ) + wasm_i32x4_extract_lane( v, 3 );
+}
+
+static ALWAYS_INLINE int pixel_sad_wxh_simd128( uint8_t *pix1, intptr_t i_pix1,
+                                                uint8_t *pix2, intptr_t i_pix2,
+                                                int lx, int ly )
+{
+    /* 16 rows of 16 pixels sum to at most 16*16*255/8 per lane: no overflow */
+    v128_t sum = wasm_i16x8_splat( 0 );
+    for( int y = 0; y < ly; y++ )
+    {
+        if( lx == 16 )
+            sum = wasm_i16x8_add( sum, absdiff_u8( wasm_v128_load( pix1 ), wasm_v128_load( pix2 ) ) );
+        else
+            sum = wasm_i16x8_add( sum, absdiff_u8( wasm_v128_load64_zero( pix1 ), wasm_v128_load64_zero( pix2 ) ) );
+        pix1 += i_pix1;
+        pix2 += i_pix2;
+    }
+    return hsum_u16( sum );
+}
+
+#define PIXEL_SAD_SIMD128( lx, ly )\
+static int pixel_sad_##lx##x##ly##_simd128( uint8_t *pix1, intptr_t i_pix1,\
+                                             uint8_t *pix2, intptr_t i_pix2 )\
+{\
+    return pixel_sad_wxh_simd128( pix1, i_pix1, pix2, i_pix2, lx, ly );\
+}\
+static void pixel_sad_x3_##lx##x##ly##_simd128( uint8_t *fenc, uint8_t *pix0, uint8_t *pix1,\
+                                                 uint8_t *pix2, intptr_t i_stride, int scores[3] )\
+{\
+    scores[0] = pixel_sad_wxh_simd128( fenc, FENC_STRIDE, pix0, i_stride, lx, ly );\
+    scores[1] = pixel_sad_wxh_simd128( fenc, FENC_STRIDE, pix1, i_stride, lx, ly );\
+    scores[2] = pixel_sad_wxh_simd128( fenc, FENC_STRIDE, pix2, i_stride, lx, ly );\
+}\
+static void pixel_sad_x4_##lx##x##ly##_simd128( uint8_t *fenc, uint8_t *pix0, uint8_t *pix1,\
+                                                 uint8_t *pix2, uint8_t *pix3, intptr_t i_stride,\
+                                                 int scores[4] )\
+{\
+    scores[0] = pixel_sad_wxh_simd128( fenc, FENC_STRIDE, pix0, i_stride, lx, ly );\
+    scores[1] = pixel_sad_wxh_simd128( fenc, FENC_STRIDE, pix1, i_stride, lx, ly );\
+    scores[2] = pixel_sad_wxh_simd128( fenc, FENC_STRIDE, pix2, i_stride, lx, ly );\
+    scores[3] = pixel_sad_wxh_simd128( fenc, FENC_STRIDE, pix3, i_stride, lx, ly );\
+}
+
+PIXEL_SAD_SIMD128( 16, 16 )
+PIXEL_SAD_SIMD128( 16, 8 )
+PIXEL_SAD_SIMD128( 8, 16 )
+PIXEL_SAD_SIMD128( 8, 8 )
+PIXEL_SAD_SIMD128( 8, 4 )
+
+/***********************************************************************
+ * SSD routines
+ **********************************************************************/
+
+static ALWAYS_INLINE int pixel_ssd_wxh_simd128( uint8_t *pix1, intptr_t i_pix1,
+                                                uint8_t *pix2, intptr_t i_pix2,
+                                                int lx, int ly )
+{
+    v128_t sum = wasm_i32x4_splat( 0 );
+    for( int y = 0; y < ly; y++ )
+    {
+        for( int x = 0; x < lx; x += 8 )
+        {
+            v128_t d = wasm_i16x8_sub( wasm_u16x8_load8x8( pix1+x ), wasm_u16x8_load8x8( pix2+x ) );
+            sum = wasm_i32x4_add( sum, wasm_i32x4_dot_i16x8( d, d ) );
+        }
+        pix1 += i_pix1;
+        pix2 += i_pix2;
+    }
+    return wasm_i32x4_extract_lane( sum, 0 ) + wasm_i32x4_extract_lane( sum, 1 )
+         + wasm_i32x4_extract_lane( sum, 2 ) + wasm_i32x4_extract_lane( sum, 3 );
+}
+
+#define PIXEL_SSD_SIMD128( lx, ly )\
+static int pixel_ssd_##lx##x##ly##_simd128( uint8_t *pix1, intptr_t i_pix1,\
+                                             uint8_t *pix2, intptr_t i_pix2 )\
+{\
+    return pixel_ssd_wxh_simd128( pix1, i_pix1, pix2, i_pix2, lx, ly );\
+}
+
+PIXEL_SSD_SIMD128( 16, 16 )
+PIXEL_SSD_SIMD128( 16, 8 )
+PIXEL_SSD_SIMD128( 8, 16 )
+PIXEL_SSD_SIMD128( 8, 8 )
+PIXEL_SSD_SIMD128( 8, 4 )
+
+/***********************************************************************
+ * SATD routines
+ **********************************************************************/
+
+/* 4-point hadamard on each group of 4 lanes. The sign of the outputs
+ * differs from HADAMARD4, which doesn't matter as only |x| is summed. */
+static ALWAYS_INLINE v128_t hadamard4_lanes( v128_t v )
+{
+    v128_t s = wasm_i16x8_shuffle( v, v, 1, 0, 3, 2, 5, 4, 7, 6 );
+    v128_t t = wasm_i16x8_shuffle( wasm_i16x8_add( v, s ), wasm_i16x8_sub( v, s ),
+                                   0, 8, 2, 10, 4, 12, 6, 14 );
+    s = wasm_i16x8_shuffle( t, t, 2, 3, 0, 1, 6, 7, 4, 5 );
+    return wasm_i16x8_shuffle( wasm_i16x8_add( t, s ), wasm_i16x8_sub( t, s ),
+                               0, 1, 10, 11, 4, 5, 14, 15 );
+}
+
+static int pixel_satd_8x4_simd128( uint8_t *pix1, intptr_t i_pix1,
+                                   uint8_t *pix2, intptr_t i_pix2 )
+{
+    v128_t d0 = wasm_i16x8_sub( wasm_u16x8_load8x8( pix1 ),          wasm_u16x8_load8x8( pix2 ) );
+    v128_t d1 = wasm_i16x8_sub( wasm_u16x8_load8x8( pix1+1*i_pix1 ), wasm_u16x8_load8x8( pix2+1*i_pix2 ) );
+    v128_t d2 = wasm_i16x8_sub( wasm_u16x8_load8x8( pix1+2*i_pix1 ), wasm_u16x8_load8x8( pix2+2*i_pix2 ) );
+    v128_t d3 = wasm_i16x8_sub( wasm_u16x8_load8x8( pix1+3*i_pix1 ), wasm_u16x8_load8x8( pix2+3*i_pix2 ) );
+    v128_t a0 = wasm_i16x8_add( d0, d1 ), a1 = wasm_i16x8_sub( d0, d1 );
+    v128_t a2 = wasm_i16x8_add( d2, d3 ), a3 = wasm_i16x8_sub( d2, d3 );
+    v128_t sum;
+
+    d0 = hadamard4_lanes( wasm_i16x8_add( a0, a2 ) );
+    d1 = hadamard4_lanes( wasm_i16x8_sub( a0, a2 ) );
+    d2 = hadamard4_lanes( wasm_i16x8_add( a1, a3 ) );
+    d3 = hadamard4_lanes( wasm_i16x8_sub( a1, a3 ) );
+
+    /* each coefficient is at most 16*255, so four of them fit in 16 bits */
+    sum = wasm_i16x8_add( wasm_i16x8_add( wasm_i16x8_abs( d0 ), wasm_i16x8_abs( d1 ) ),
+                          wasm_i16x8_add( wasm_i16x8_abs( d2 ), wasm_i16x8_abs( d3 ) ) );
+    return hsum_u16( sum ) >> 1;
+}
+
+#define PIXEL_SATD_SIMD128( w, h )\
+static int pixel_satd_##w##x##h##_simd128( uint8_t *pix1, intptr_t i_pix1,\
+                                            uint8_t *pix2, intptr_t i_pix2 )\
+{\
+    int sum = 0;\
+    for( int y = 0; y < h; y += 4 )\
+        for( int x = 0; x < w; x += 8 )\
+            sum += pixel_satd_8x4_simd128( pix1+x+y*i_pix1, i_pix1, pix2+x+y*i_pix2, i_pix2 );\
+    return sum;\
+}
+
+PIXEL_SATD_SIMD128( 16, 16 )
+PIXEL_SATD_SIMD128( 16, 8 )
+PIXEL_SATD_SIMD128( 8, 16 )
+PIXEL_SATD_SIMD128( 8, 8 )
+#endif // !HIGH_BIT_DEPTH
+
+/****************************************************************************
+ * x264_pixel_simd128_init:
+ ****************************************************************************/
+void x264_pixel_simd128_init( x264_pixel_function_t *pixf )
+{
+#if !HIGH_BIT_DEPTH
+    pixf->sad[PIXEL_16x16] = pixel_sad_16x16_simd128;
+    pixf->sad[PIXEL_16x8]  = pixel_sad_16x8_simd128;
+    pixf->sad[PIXEL_8x16]  = pixel_sad_8x16_simd128;
+    pixf->sad[PIXEL_8x8]   = pixel_sad_8x8_simd128;
+    pixf->sad[PIXEL_8x4]   = pixel_sad_8x4_simd128;
+
+    pixf->sad_x3[PIXEL_16x16] = pixel_sad_x3_16x16_simd128;
+    pixf->sad_x3[PIXEL_16x8]  = pixel_sad_x3_16x8_simd128;
+    pixf->sad_x3[PIXEL_8x16]  = pixel_sad_x3_8x16_simd128;
+    pixf->sad_x3[PIXEL_8x8]   = pixel_sad_x3_8x8_simd128;
+    pixf->sad_x3[PIXEL_8x4]   = pixel_sad_x3_8x4_simd128;
+
+    pixf->sad_x4[PIXEL_16x16] = pixel_sad_x4_16x16_simd128;
+    pixf->sad_x4[PIXEL_16x8]  = pixel_sad_x4_16x8_simd128;
+    pixf->sad_x4[PIXEL_8x16]  = pixel_sad_x4_8x16_simd128;
+    pixf->sad_x4[PIXEL_8x8]   = pixel_sad_x4_8x8_simd128;
+    pixf->sad_x4[PIXEL_8x4]   = pixel_sad_x4_8x4_simd128;
+
+    pixf->ssd[PIXEL_16x16] = pixel_ssd_16x16_simd128;
+    pixf->ssd[PIXEL_16x8]  = pixel_ssd_16x8_simd128;
+    pixf->ssd[PIXEL_8x16]  = pixel_ssd_8x16_simd128;
+    pixf->ssd[PIXEL_8x8]   = pixel_ssd_8x8_simd128;
+    pixf->ssd[PIXEL_8x4]   = pixel_ssd_8x4_simd128;
+
+    pixf->satd[PIXEL_16x16] = pixel_satd_16x16_simd128;
+    pixf->satd[PIXEL_16x8]  = pixel_satd_16x8_simd128;
+    pixf->satd[PIXEL_8x16]  = pixel_satd_8x16_simd128;
+    pixf->satd[PIXEL_8x8]   = pixel_satd_8x8_simd128;
+    pixf->satd[PIXEL_8x4]   = pixel_satd_8x4_simd128;
+#endif // !HIGH_BIT_DEPTH
+}
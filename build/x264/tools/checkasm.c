@@ -181,6 +181,8 @@ static void print_bench(void)
                     b->cpu&X264_CPU_MMX ? "mmx" :
 #elif ARCH_PPC
                     b->cpu&X264_CPU_ALTIVEC ? "altivec" :
+#elif ARCH_WASM
+                    b->cpu&X264_CPU_SIMD128 ? "simd128" :
 #elif ARCH_ARM
                     b->cpu&X264_CPU_NEON ? "neon" :
                     b->cpu&X264_CPU_ARMV6 ? "armv6" :
@@ -2720,6 +2722,12 @@ static int check_all_flags( void )
         fprintf( stderr, "x264: ALTIVEC against C\n" );
         ret = check_all_funcs( 0, X264_CPU_ALTIVEC );
     }
+#elif ARCH_WASM
+    if( x264_cpu_detect() & X264_CPU_SIMD128 )
+    {
+        fprintf( stderr, "x264: SIMD128 against C\n" );
+        ret = check_all_funcs( 0, X264_CPU_SIMD128 );
+    }
 #elif ARCH_ARM
     if( x264_cpu_detect() & X264_CPU_ARMV6 )
         ret |= add_flags( &cpu0, &cpu1, X264_CPU_ARMV6, "ARMv6" );
@@ -152,6 +152,9 @@ typedef struct
 /* PowerPC */
 #define X264_CPU_ALTIVEC         0x0000001
 
+/* WebAssembly */
+#define X264_CPU_SIMD128         0x0000001  /* 128-bit packed SIMD proposal */
+
 /* ARM */
 #define X264_CPU_ARMV6           0x0000001
 #define X264_CPU_NEON            0x0000002  /* ARM NEON */
@@ -0,0 +1,230 @@
+/*
+Transcodes one video on several workers at once.
+
+The input is cut at its keyframes with stream copy (the segment muxer), every
+segment is encoded on whichever worker is free, and the encoded segments are
+joined with the concat demuxer and stream copy, so nothing is encoded twice
+and the joins are not re-encoded.  Audio is not split; it is taken from the
+original input when the segments are joined.
+
+  transcodeSegmented({
+    src: "worker-asm.js",        worker script, as in demo/
+    workers: 4,                  defaults to navigator.hardwareConcurrency
+    name: "input.webm",
+    data: Uint8Array,
+    segmentTime: 5,              seconds; segments start at the first keyframe
+                                 after each multiple of this
+    videoArguments: ["-c:v", "libx264"],
+    audioArguments: ["-c:a", "copy"],
+    output: "output.mp4",
+    print: function(text) {}    optional, gets every worker's output
+    readyTimeout: 60000,         ms to wait for all workers to load, after
+                                 which the transcode fails
+  }, function(error, files) {
+    // error is null on success, else a message saying which step failed;
+    // files is the same as the "done" data of a worker: [{ name, data }]
+  });
+*/
+
+function transcodeSegmented(opts, cb) {
+  var workerCount = opts.workers || navigator.hardwareConcurrency || 1;
+  var segmentTime = opts.segmentTime || 5;
+  var videoArguments = opts.videoArguments || [];
+  var audioArguments = opts.audioArguments || ["-c:a", "copy"];
+  var print = opts.print || function() {};
+  var started = [];
+  var workers = [];
+  var idle = [];
+  var queue = [];
+  var finished = false;
+
+  /* a worker that fails to load reports it through onerror, but one that
+     loads and never gets its runtime going (e.g. a pthreads build on a page
+     that is not cross-origin isolated) is only caught by the timeout */
+  var readyTimer = setTimeout(function() {
+    finish((workerCount - workers.length) + " of " + workerCount + " workers (" + opts.src +
+           ") were not ready after " + (opts.readyTimeout || 60000) + "ms");
+  }, opts.readyTimeout || 60000);
+
+  for (var i = 0; i < workerCount; i++) {
+    startWorker();
+  }
+
+  /* Workers keep their converter instance between commands, so each one
+     only pays for the module setup once. */
+  function startWorker() {
+    var worker = new Worker(opts.src);
+    started.push(worker);
+    worker.onerror = function(event) {
+      event.preventDefault();
+      finish("worker " + opts.src + " failed: " + (event.message || "could not be loaded"));
+    };
+    worker.onmessage = function(event) {
+      var message = event.data;
+      if (message.type == "ready") {
+        workers.push(worker);
+        idle.push(worker);
+        if (workers.length === workerCount) {
+          clearTimeout(readyTimer);
+          split();
+        }
+      } else if (message.type == "stdout") {
+        print(message.data);
+        if (worker.onstdout) {
+          worker.onstdout(message.data);
+        }
+      } else if (message.type == "done") {
+        var done = worker.ondone;
+        worker.ondone = null;
+        worker.onstdout = null;
+        idle.push(worker);
+        done(message.data, message.exitCode);
+        next();
+      }
+    };
+  }
+
+  function run(args, files, done, onstdout) {
+    queue.push({ arguments: args, files: files, done: done, onstdout: onstdout });
+    next();
+  }
+
+  function next() {
+    while (queue.length && idle.length) {
+      var job = queue.shift();
+      var worker = idle.shift();
+      worker.ondone = job.done;
+      worker.onstdout = job.onstdout;
+      worker.postMessage({
+        type: "command",
+        arguments: job.arguments,
+        files: job.files
+      });
+    }
+  }
+
+  /* The first failure ends the whole transcode; segment jobs still queued or
+     running are dropped with their workers. */
+  function finish(error, files) {
+    if (finished) {
+      return;
+    }
+    finished = true;
+    clearTimeout(readyTimer);
+    queue = [];
+    started.forEach(function(worker) {
+      worker.terminate();
+    });
+    cb(error, error ? [] : files);
+  }
+
+  /* Only the first video stream is split.  The segment list gives the time
+     each segment starts at, which becomes its duration in the concat list
+     so the joined timestamps line up with the input. */
+  function split() {
+    var hasAudio = false;
+    var args = [
+      "-i", opts.name, "-map", "0:v:0", "-c", "copy",
+      "-f", "segment", "-segment_time", String(segmentTime),
+      "-segment_list", "output/segments.csv", "-segment_list_type", "csv",
+      "segment%03d.mkv"
+    ];
+    run(args, [{ name: opts.name, data: opts.data }], function(files, exitCode) {
+      var list = getFile(files, "segments.csv");
+      if (exitCode || !list) {
+        return finish("splitting " + opts.name + " failed (exit code " + exitCode + ")");
+      }
+      var segments = parseSegmentList(list.data).map(function(segment) {
+        segment.file = getFile(files, segment.name);
+        return segment;
+      });
+      encode(segments, hasAudio);
+    }, function(text) {
+      /* -map NAME? is not supported, so the join needs to know whether
+         there is an audio stream to map */
+      if (/^\s*Stream #0:\d+.*: Audio:/.test(text)) {
+        hasAudio = true;
+      }
+    });
+  }
+
+  function encode(segments, hasAudio) {
+    var remaining = segments.length;
+    var encoded = [];
+    if (segments.length === 0) {
+      return finish("splitting " + opts.name + " gave no segments");
+    }
+    for (var i = 0; i < segments.length; i++) {
+      if (!segments[i].file) {
+        return finish("segment " + segments[i].name + " is missing");
+      }
+    }
+    segments.forEach(function(segment, i) {
+      var name = "encoded" + ("00" + i).slice(-3) + ".mkv";
+      var args = ["-i", segment.name].concat(videoArguments, ["-an", name]);
+      run(args, [{ name: segment.name, data: new Uint8Array(segment.file.data) }], function(files, exitCode) {
+        encoded[i] = getFile(files, name);
+        if (exitCode || !encoded[i]) {
+          return finish("encoding " + segment.name + " failed (exit code " + exitCode + ")");
+        }
+        if (--remaining === 0) {
+          join(segments, encoded, hasAudio);
+        }
+      });
+    });
+  }
+
+  function join(segments, encoded, hasAudio) {
+    var list = "";
+    var files = [];
+    for (var i = 0; i < segments.length; i++) {
+      list += "file '" + encoded[i].name + "'\n";
+      if (i + 1 < segments.length) {
+        list += "duration " + (segments[i + 1].start - segments[i].start).toFixed(6) + "\n";
+      }
+      files.push({ name: encoded[i].name, data: new Uint8Array(encoded[i].data) });
+    }
+    files.push({ name: "segments.txt", data: stringToBytes(list) });
+
+    var args = ["-f", "concat", "-i", "segments.txt"];
+    if (hasAudio) {
+      files.push({ name: opts.name, data: opts.data });
+      args = args.concat(["-i", opts.name, "-map", "0:v", "-map", "1:a"], audioArguments);
+    }
+    args = args.concat(["-c:v", "copy", opts.output]);
+    run(args, files, function(files, exitCode) {
+      if (exitCode || !getFile(files, opts.output)) {
+        return finish("joining the segments failed (exit code " + exitCode + ")");
+      }
+      finish(null, files);
+    });
+  }
+
+  function getFile(files, name) {
+    for (var i = 0; i < files.length; i++) {
+      if (files[i].name === name) {
+        return files[i];
+      }
+    }
+    return null;
+  }
+
+  /* segment muxer csv: name,start time,end time */
+  function parseSegmentList(data) {
+    var text = String.fromCharCode.apply(null, new Uint8Array(data));
+    return text.split("\n").filter(function(line) {
+      return line.length;
+    }).map(function(line) {
+      var fields = line.split(",");
+      return { name: fields[0], start: parseFloat(fields[1]) };
+    });
+  }
+
+  function stringToBytes(str) {
+    var bytes = new Uint8Array(str.length);
+    for (var i = 0; i < str.length; i++) {
+      bytes[i] = str.charCodeAt(i);
+    }
+    return bytes;
+  }
+}
@@ -0,0 +1,137 @@
+// The threaded build needs SharedArrayBuffer, which is only there when the
+// page is cross-origin isolated.  Without it the runtime would never start,
+// so fail the worker instead; its owner sees that through onerror.
+if (typeof SharedArrayBuffer === 'undefined' || self.crossOriginIsolated === false) {
+  throw new Error('ffmpeg-threaded.js needs SharedArrayBuffer: serve the page cross-origin isolated');
+}
+
+importScripts('../build/ffmpeg-threaded.js');
+
+var now = Date.now;
+
+// Created with the threads and maxInputs of the first message and reused
+// for every command after it, with the settings that come with a command
+// passed to run() for that job only.  The worker pool is sized on creation
+// (see ffmpeg_pre.js), so a later command with more threads or inputs than
+// the first one allowed is refused.  The threaded runtime starts
+// asynchronously; messages that arrive before instance.ready() fires wait in
+// pending.
+var instance;
+var instanceThreads;
+var pending = null;
+
+function print(text) {
+  postMessage({
+    'type' : 'stdout',
+    'data' : text
+  });
+}
+
+function stats(data) {
+  postMessage({
+    'type' : 'stats',
+    'data' : data
+  });
+}
+
+function chunk(name, data, position) {
+  postMessage({
+    'type' : 'chunk',
+    'name' : name,
+    'position' : position,
+    'data' : data
+  }, [data.buffer]);
+}
+
+onmessage = function(event) {
+
+  var message = event.data;
+
+  if (!instance) {
+    instanceThreads = message.threads || navigator.hardwareConcurrency || 1;
+    instance = ffmpeg_instance({
+      print: print,
+      printErr: print,
+      threads: instanceThreads,
+      maxInputs: message.maxInputs || 1
+    });
+    pending = [message];
+    instance.ready(function() {
+      pending.splice(0).forEach(handleMessage);
+      pending = null;
+    });
+  } else if (pending) {
+    pending.push(message);
+  } else {
+    handleMessage(message);
+  }
+};
+
+function handleMessage(message) {
+
+  if (message.type === "command") {
+
+    var Module = {
+      files: message.files || [],
+      arguments: message.arguments || [],
+      threads: message.threads || instanceThreads,
+      // Heap size to start the job with; the heap grows as needed up to the
+      // MAXIMUM_MEMORY the module was built with.
+      TOTAL_MEMORY: message.TOTAL_MEMORY || false
+    };
+
+    postMessage({
+      'type' : 'start',
+      'data' : Module.arguments.join(" ")
+    });
+
+    postMessage({
+      'type' : 'stdout',
+      'data' : 'Received command: ' +
+                Module.arguments.join(" ") +
+                ((Module.TOTAL_MEMORY) ? ".  Processing with " + Module.TOTAL_MEMORY + " bits." : "")
+    });
+
+    var time = now();
+    instance.onStats = message.stats ? stats : null;
+    instance.statsPeriod = message.statsPeriod || 1;
+    var result = instance.run(Module.arguments, Module.files, {
+      fragmented: message.fragmented,
+      threads: Module.threads,
+      onOutputChunk: chunk,
+      TOTAL_MEMORY: Module.TOTAL_MEMORY
+    });
+
+    var totalTime = now() - time;
+    postMessage({
+      'type' : 'stdout',
+      'data' : 'Finished processing (took ' + totalTime + 'ms)'
+    });
+
+    postMessage({
+      'type' : 'done',
+      'data' : result,
+      'exitCode' : instance.exitCode,
+      'time' : totalTime
+    });
+  }
+
+  if (message.type === "thumbnails") {
+
+    var time = now();
+    var thumbnails = instance.thumbnails(message.file, message.count || 1, message.width, message.height);
+
+    postMessage({
+      'type' : 'done',
+      'data' : thumbnails,
+      'exitCode' : instance.exitCode,
+      'time' : now() - time
+    }, thumbnails.map(function(thumbnail) {
+      return thumbnail.data;
+    }));
+  }
+}
+
+postMessage({
+  'type' : 'ready'
+});
@@ -2,6 +2,10 @@ importScripts('../build/ffmpeg.js');
 
 var now = Date.now;
 
+// Created on the first command and reused for the ones after it.  Settings
+// that come with a command are passed to run() for that job only.
+var instance;
+
 function print(text) {
   postMessage({
     'type' : 'stdout',
@@ -9,6 +13,22 @@ function print(text) {
   });
 }
 
+function stats(data) {
+  postMessage({
+    'type' : 'stats',
+    'data' : data
+  });
+}
+
+function chunk(name, data, position) {
+  postMessage({
+    'type' : 'chunk',
+    'name' : name,
+    'position' : position,
+    'data' : data
+  }, [data.buffer]);
+}
+
 onmessage = function(event) {
 
   var message = event.data;
@@ -16,13 +36,11 @@ onmessage = function(event) {
   if (message.type === "command") {
 
     var Module = {
-      print: print,
-      printErr: print,
       files: message.files || [],
       arguments: message.arguments || [],
+      // Heap size to start the job with; the heap grows as needed up to the
+      // MAXIMUM_MEMORY the module was built with.
       TOTAL_MEMORY: message.TOTAL_MEMORY || false
-      // Can play around with this option - must be a power of 2
-      // TOTAL_MEMORY: 268435456
     };
 
     postMessage({
@@ -38,7 +56,19 @@ onmessage = function(event) {
     });
 
     var time = now();
-    var result = ffmpeg_run(Module);
+    if (!instance) {
+      instance = ffmpeg_instance({
+        print: print,
+        printErr: print
+      });
+    }
+    instance.onStats = message.stats ? stats : null;
+    instance.statsPeriod = message.statsPeriod || 1;
+    var result = instance.run(Module.arguments, Module.files, {
+      fragmented: message.fragmented,
+      onOutputChunk: chunk,
+      TOTAL_MEMORY: Module.TOTAL_MEMORY
+    });
 
     var totalTime = now() - time;
     postMessage({
@@ -49,9 +79,32 @@ onmessage = function(event) {
     postMessage({
       'type' : 'done',
       'data' : result,
+      'exitCode' : instance.exitCode,
       'time' : totalTime
     });
   }
+
+  if (message.type === "thumbnails") {
+
+    if (!instance) {
+      instance = ffmpeg_instance({
+        print: print,
+        printErr: print
+      });
+    }
+
+    var time = now();
+    var thumbnails = instance.thumbnails(message.file, message.count || 1, message.width, message.height);
+
+    postMessage({
+      'type' : 'done',
+      'data' : thumbnails,
+      'exitCode' : instance.exitCode,
+      'time' : now() - time
+    }, thumbnails.map(function(thumbnail) {
+      return thumbnail.data;
+    }));
+  }
 };
 
 postMessage({
@@ -0,0 +1,56 @@
+# Native builds of the libraries in ../build, for comparing against the
+# emscripten builds.  Everything is built C only (no yasm or inline asm, libvpx
+# generic-gnu), so this is a C-only baseline: the wasm build has SIMD128 code
+# that this one does not, and its results are labelled "native-c".
+# NATIVE_ASM=1 builds with the x86 assembly instead, labelled "native-asm".
+#
+# Produces native/dist (libraries and headers), native/ffmpeg/ffmpeg and the
+# micro benchmarks in native/bench.
+set -e
+cd "$(dirname "$0")"
+
+SRC=$(pwd)/../build
+OUT=$(pwd)/native
+JOBS=${JOBS:-$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)}
+
+if [ "$NATIVE_ASM" = "1" ]; then
+  VPX_FLAGS=""
+  X264_FLAGS=""
+  FFMPEG_FLAGS=""
+  TARGET=native-asm
+else
+  VPX_FLAGS="--target=generic-gnu"
+  X264_FLAGS="--disable-asm"
+  FFMPEG_FLAGS="--disable-asm"
+  TARGET=native-c
+fi
+
+mkdir -p $OUT/libvpx $OUT/x264 $OUT/ffmpeg $OUT/bench
+# read by run.sh for the target of the macro results
+echo $TARGET > $OUT/target
+
+cd $OUT/libvpx
+$SRC/libvpx/configure --prefix=$OUT/dist --disable-examples --disable-docs --disable-unit-tests $VPX_FLAGS
+make -j$JOBS
+make install
+
+cd $OUT/x264
+$SRC/x264/configure --prefix=$OUT/dist --disable-cli --enable-static $X264_FLAGS
+make -j$JOBS
+make install
+
+# Same feature set as build_all_codecs.sh, minus the emscripten specifics.
+cd $OUT/ffmpeg
+$SRC/ffmpeg/configure --prefix=$OUT/dist $FFMPEG_FLAGS \
+    --extra-cflags="-I$OUT/dist/include" --extra-ldflags="-L$OUT/dist/lib" --extra-libs="-lpthread -lm" \
+    --disable-ffplay --disable-ffprobe --disable-ffserver --disable-doc --disable-devices --disable-network \
+    --disable-hwaccels --disable-debug --disable-indevs --disable-outdevs \
+    --enable-libvpx --enable-libx264 --enable-gpl
+make -j$JOBS
+make install
+
+cd $OUT/bench
+cc -O3 -DBENCH_TARGET=\"$TARGET\" -I$OUT/ffmpeg -I$SRC/ffmpeg -o ffmpeg_kernels ../../micro/ffmpeg_kernels.c \
+    -L$OUT/dist/lib -lswscale -lavcodec -lavutil -lm -lpthread
+cc -O3 -DBENCH_TARGET=\"$TARGET\" -I$OUT/x264 -I$SRC/x264 -o x264_kernels ../../micro/x264_kernels.c \
+    -L$OUT/dist/lib -lx264 -lm -lpthread
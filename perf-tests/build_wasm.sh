@@ -0,0 +1,60 @@
+# Emscripten builds of the micro benchmarks, in two variants that are run and
+# labelled separately:
+#
+#   wasm/scalar    x264 --disable-asm, ffmpeg --disable-simd128, benchmarks
+#                  without -msimd128; results labelled "wasm"
+#   wasm/simd128   x264 and ffmpeg with their -msimd128 code, benchmarks built
+#                  with -msimd128; results labelled "wasm-simd128"
+#
+# Only the libraries the benchmarks link are built, out of tree, from the
+# sources in ../build, so ../build/x264 and ../build/ffmpeg must not be
+# configured in place at the same time (run this before
+# ../build/build_all_codecs.sh, or "make distclean" there first).  The macro
+# benchmarks use ../build/ffmpeg-all-codecs.js directly.
+#
+# Produces wasm/<variant>/bench/*.js, to be run with node.
+set -e
+cd "$(dirname "$0")"
+
+SRC=$(pwd)/../build
+JOBS=${JOBS:-$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)}
+
+# Same optimization level as the ffmpeg build; the heap grows as needed, since
+# the swscale benchmarks want more than the default.
+EMCC_FLAGS="-O2 -s ALLOW_MEMORY_GROWTH=1 -s ENVIRONMENT=node"
+
+for VARIANT in scalar simd128; do
+  OUT=$(pwd)/wasm/$VARIANT
+  if [ "$VARIANT" = "simd128" ]; then
+    X264_FLAGS=""
+    FFMPEG_FLAGS=""
+    BENCH_FLAGS="-msimd128"
+  else
+    X264_FLAGS="--disable-asm"
+    FFMPEG_FLAGS="--disable-simd128"
+    BENCH_FLAGS=""
+  fi
+
+  mkdir -p $OUT/x264 $OUT/ffmpeg $OUT/bench
+
+  (cd $OUT/x264 &&
+   emconfigure $SRC/x264/configure --disable-thread --host=wasm32-unknown-linux-gnu \
+       --disable-cli --enable-static --disable-gpl --prefix=$OUT/dist $X264_FLAGS &&
+   emmake make -j$JOBS && emmake make install)
+
+  (cd $OUT/ffmpeg &&
+   emconfigure $SRC/ffmpeg/configure --cc="emcc" --prefix=$OUT/dist --enable-cross-compile \
+       --target-os=none --arch=wasm --cpu=generic $FFMPEG_FLAGS \
+       --disable-programs --disable-doc --disable-avdevice --disable-avformat --disable-avfilter \
+       --disable-swresample --disable-postproc --disable-pthreads --disable-w32threads \
+       --disable-network --disable-inline-asm --disable-yasm --disable-debug &&
+   emmake make -j$JOBS && emmake make install)
+
+  # bench.h labels the results "wasm-simd128" when built with -msimd128.
+  cd $OUT/bench
+  emcc $EMCC_FLAGS $BENCH_FLAGS -I$OUT/ffmpeg -I$SRC/ffmpeg -o ffmpeg_kernels.js ../../../micro/ffmpeg_kernels.c \
+      $OUT/dist/lib/libswscale.a $OUT/dist/lib/libavcodec.a $OUT/dist/lib/libavutil.a
+  emcc $EMCC_FLAGS $BENCH_FLAGS -I$OUT/x264 -I$SRC/x264 -o x264_kernels.js ../../../micro/x264_kernels.c \
+      $OUT/dist/lib/libx264.a
+  cd ../../..
+done
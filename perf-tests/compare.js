@@ -0,0 +1,58 @@
+/*
+Compares two result directories written by run.sh, e.g. a baseline from
+master against a branch, or results/native against results/wasm:
+
+  node compare.js <base dir> <new dir> [threshold percent, default 5]
+
+Prints the change of every benchmark present in both and exits with status 1
+if any of them got slower by more than the threshold.
+*/
+
+var fs = require('fs');
+var path = require('path');
+
+function load(dir) {
+  var results = {};
+  fs.readdirSync(dir).filter(function(name) {
+    return /\.json$/.test(name);
+  }).forEach(function(name) {
+    var suite = JSON.parse(fs.readFileSync(path.join(dir, name), 'utf8'));
+    suite.results.forEach(function(result) {
+      results[suite.suite + '/' + result.name] = result;
+    });
+  });
+  return results;
+}
+
+function main(argv) {
+  if (argv.length < 2) {
+    console.error('usage: node compare.js <base dir> <new dir> [threshold percent]');
+    process.exit(2);
+  }
+  var base = load(argv[0]);
+  var current = load(argv[1]);
+  var threshold = argv.length > 2 ? parseFloat(argv[2]) : 5;
+  var regressions = 0;
+
+  Object.keys(base).sort().forEach(function(name) {
+    if (!current[name]) {
+      return;
+    }
+    /* times, allocations and sizes: lower is better for every unit */
+    var change = (current[name].value / base[name].value - 1) * 100;
+    var regressed = change > threshold;
+    if (regressed) {
+      regressions++;
+    }
+    console.log((regressed ? '! ' : '  ') + name + ': ' +
+                base[name].value + ' -> ' + current[name].value + ' ' + current[name].unit +
+                ' (' + (change >= 0 ? '+' : '') + change.toFixed(1) + '%)');
+  });
+
+  if (regressions) {
+    console.log(regressions + ' benchmark(s) slower by more than ' + threshold + '%');
+    process.exit(1);
+  }
+}
+
+main(process.argv.slice(2));
@@ -0,0 +1,139 @@
+/*
+Shared by the macro suites: the synthetic video source and the runners that
+execute one ffmpeg command line natively or on the wasm build.
+*/
+
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var vm = require('vm');
+var childProcess = require('child_process');
+
+/* A textured picture panning diagonally with a bit of noise, so encoders
+   have motion to find and nothing compresses to zero.  yuv420p. */
+function makeVideo(width, height, frames) {
+  var ySize = width * height, cSize = ySize / 4;
+  var data = new Uint8Array(frames * (ySize + 2 * cSize));
+  var seed = 1;
+  for (var f = 0, pos = 0; f < frames; f++) {
+    for (var y = 0; y < height; y++) {
+      for (var x = 0; x < width; x++) {
+        seed = (seed * 1664525 + 1013904223) >>> 0;
+        var u = x + 3 * f, v = y + 2 * f;
+        data[pos++] = ((u ^ v) & 0x3f) + ((u >> 3) & 0x7f) + (seed >>> 29);
+      }
+    }
+    for (var plane = 0; plane < 2; plane++) {
+      for (var y = 0; y < height / 2; y++) {
+        for (var x = 0; x < width / 2; x++) {
+          data[pos++] = 128 + (plane ? y - f : x + f) % 64 - 32;
+        }
+      }
+    }
+  }
+  return data;
+}
+
+/* Each runner takes (args, files, onStats) with files a map of name to
+   Uint8Array and returns the outputs the same way, or throws if ffmpeg
+   failed.  onStats, if given, receives the -stats_json reports of the job. */
+function nativeRunner(binary) {
+  binary = path.resolve(binary);
+  var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'vcjs-bench-'));
+  var statsFile = path.join(dir, 'stats.ndjson');
+  fs.mkdirSync(path.join(dir, 'output'));
+  return function(args, files, onStats) {
+    Object.keys(files).forEach(function(name) {
+      fs.writeFileSync(path.join(dir, name), files[name]);
+    });
+    args = args.slice();
+    var last = args.length - 1;
+    if (args[last].indexOf('.') > -1) {
+      args[last] = 'output/' + args[last];
+    }
+    if (onStats) {
+      args = ['-stats_json', statsFile, '-stats_json_period', '3600'].concat(args);
+    }
+    var result = childProcess.spawnSync(binary, ['-nostdin', '-y', '-v', 'error'].concat(args), { cwd: dir });
+    if (result.status !== 0) {
+      throw new Error('ffmpeg ' + args.join(' ') + ' failed:\n' + (result.error || result.stderr));
+    }
+    if (onStats) {
+      fs.readFileSync(statsFile, 'utf8').split('\n').forEach(function(line) {
+        if (line) {
+          onStats(JSON.parse(line));
+        }
+      });
+      fs.unlinkSync(statsFile);
+    }
+    var outputs = {};
+    fs.readdirSync(path.join(dir, 'output')).forEach(function(name) {
+      var file = path.join(dir, 'output', name);
+      outputs[name] = new Uint8Array(fs.readFileSync(file));
+      fs.unlinkSync(file);
+    });
+    Object.keys(files).forEach(function(name) {
+      fs.unlinkSync(path.join(dir, name));
+    });
+    return outputs;
+  };
+}
+
+/* The build is loaded the way the workers see it: without exports, so
+   ffmpeg_instance() is the browser API rather than the node entry point. */
+function wasmRunner(script) {
+  var errors = [];
+  var context = vm.createContext({
+    console: console,
+    performance: require('perf_hooks').performance,
+    TextDecoder: TextDecoder,
+    setTimeout: setTimeout,
+    clearTimeout: clearTimeout
+  });
+  vm.runInContext(fs.readFileSync(script, 'utf8'), context, { filename: script });
+
+  var opts = {
+    print: function() {},
+    printErr: function(text) { errors.push(text); }
+  };
+  var wasm = script.replace(/\.js$/, '.wasm');
+  if (fs.existsSync(wasm)) {
+    opts.wasmBinary = new Uint8Array(fs.readFileSync(wasm));
+  }
+  var instance = context.ffmpeg_instance(opts);
+
+  return function(args, files, onStats) {
+    errors = [];
+    var outputs = {};
+    instance.onStats = onStats || null;
+    instance.statsPeriod = 3600;
+    var buffers = instance.run(['-v', 'error'].concat(args), Object.keys(files).map(function(name) {
+      return { name: name, data: files[name] };
+    }));
+    if (instance.exitCode !== 0) {
+      throw new Error('ffmpeg ' + args.join(' ') + ' failed:\n' + errors.join('\n'));
+    }
+    buffers.forEach(function(buffer) {
+      outputs[buffer.name] = new Uint8Array(buffer.data);
+    });
+    return outputs;
+  };
+}
+
+function create(target, binary) {
+  return target === 'native' ? nativeRunner(binary) : wasmRunner(binary);
+}
+
+function select(files, names) {
+  var selected = {};
+  names.forEach(function(name) {
+    selected[name] = files[name];
+  });
+  return selected;
+}
+
+module.exports = {
+  makeVideo: makeVideo,
+  create: create,
+  select: select
+};
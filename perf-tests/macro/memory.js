@@ -0,0 +1,92 @@
+/*
+Memory benchmarks: allocator traffic and peak footprint of conversions of a
+synthetic 1080p clip, from the -stats_json report at the end of each job.
+
+  node macro/memory.js native <path to ffmpeg binary>
+  node macro/memory.js wasm <path to ffmpeg-all-codecs.js>
+
+Prints one JSON object with, per pipeline, the av_malloc() calls per frame
+once the job is running, the peak av_malloc() footprint and, for wasm, the
+size the heap had to grow to so far (all jobs run on one instance).  Opening
+the codecs and filters costs about a thousand allocations, so every pipeline
+also runs on the first SHORT frames only and the per frame figure is the
+difference between the two runs.  libvpx and libx264 allocate on their own
+and only show up in the heap size.  Lower is better for all of them, so
+compare.js works on these too.
+*/
+
+var common = require('./common');
+
+var WIDTH = 1920;
+var HEIGHT = 1080;
+var FRAMES = 25;
+var SHORT = 5;
+
+var RAW_VIDEO = ['-f', 'rawvideo', '-pix_fmt', 'yuv420p', '-s', WIDTH + 'x' + HEIGHT, '-r', '25', '-i', 'source.yuv'];
+var VP8_REALTIME = ['-c:v', 'libvpx', '-b:v', '4M', '-deadline', 'realtime', '-cpu-used', '8'];
+
+var PIPELINES = [
+  { name: 'encode_vp8_1080p', inputs: ['source.yuv'],
+    args: RAW_VIDEO.concat(VP8_REALTIME, ['output.webm']) },
+  { name: 'decode_vp8_1080p', inputs: ['source.webm'],
+    args: ['-i', 'source.webm', '-f', 'null', '-'] },
+  { name: 'scale_1080p_to_720p', inputs: ['source.webm'],
+    args: ['-i', 'source.webm', '-vf', 'scale=1280:720', '-f', 'null', '-'] },
+  { name: 'transcode_1080p_to_h264', inputs: ['source.webm'],
+    args: ['-i', 'source.webm', '-c:v', 'libx264', '-preset', 'ultrafast', 'output.mp4'] }
+];
+
+function megabytes(bytes) {
+  return +(bytes / (1024 * 1024)).toFixed(2);
+}
+
+/* The final report of one job, with the number of frames it decoded */
+function runWithStats(run, args, inputs) {
+  var report;
+  run(args, inputs, function(stats) {
+    report = stats;
+  });
+  report.frames = report.inputs.reduce(function(total, stream) {
+    return total + stream.frames;
+  }, 0);
+  return report;
+}
+
+function main(argv) {
+  var target = argv[0], binary = argv[1], filter = argv[2];
+  if ((target !== 'native' && target !== 'wasm') || !binary) {
+    console.error('usage: node memory.js native|wasm <ffmpeg binary or .js build> [name filter]');
+    process.exit(2);
+  }
+  var run = common.create(target, binary);
+
+  var files = { 'source.yuv': common.makeVideo(WIDTH, HEIGHT, FRAMES) };
+  files['source.webm'] = run(RAW_VIDEO.concat(VP8_REALTIME, ['source.webm']),
+                             common.select(files, ['source.yuv']))['source.webm'];
+
+  var results = [];
+  PIPELINES.forEach(function(pipeline) {
+    if (filter && pipeline.name.indexOf(filter) === -1) {
+      return;
+    }
+    var inputs = common.select(files, pipeline.inputs);
+    var full = runWithStats(run, pipeline.args, inputs);
+    var short = runWithStats(run, pipeline.args.slice(0, -1).concat(['-frames:v', '' + SHORT],
+                                                                     pipeline.args.slice(-1)), inputs);
+    var memory = full.memory;
+    var allocs = (memory.allocs - short.memory.allocs) / (full.frames - short.frames);
+
+    console.error(pipeline.name + ' ' + allocs.toFixed(1) + ' allocs/frame, peak ' +
+                  megabytes(memory.peak) + ' MB' +
+                  (memory.heap ? ', heap ' + megabytes(memory.heap) + ' MB' : ''));
+    results.push({ name: pipeline.name + '_allocs', value: +allocs.toFixed(2), unit: 'allocs/frame' });
+    results.push({ name: pipeline.name + '_peak', value: megabytes(memory.peak), unit: 'MB' });
+    if (memory.heap) {
+      results.push({ name: pipeline.name + '_heap', value: megabytes(memory.heap), unit: 'MB' });
+    }
+  });
+
+  console.log(JSON.stringify({ suite: 'memory', target: process.env.BENCH_TARGET || target, results: results }, null, 2));
+}
+
+main(process.argv.slice(2));
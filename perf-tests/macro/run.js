@@ -0,0 +1,100 @@
+/*
+Macro benchmarks: canned conversions timed end to end, on inputs generated
+locally so every run sees the same data.
+
+  node macro/run.js native <path to ffmpeg binary>
+  node macro/run.js wasm <path to ffmpeg-all-codecs.js>
+
+Prints one JSON object with the best of RUNS wall clock times per pipeline.
+Native runs include the process startup of every job, a few milliseconds;
+wasm runs reuse one instance (ffmpeg_instance().run()) for all jobs, which is
+how the workers use it.
+*/
+
+var common = require('./common');
+
+var RUNS = 3;
+var WIDTH = 640;
+var HEIGHT = 360;
+var FPS = 25;
+var SECONDS = 4;
+var SAMPLE_RATE = 44100;
+
+var RAW_VIDEO = ['-f', 'rawvideo', '-pix_fmt', 'yuv420p', '-s', WIDTH + 'x' + HEIGHT, '-r', '' + FPS, '-i', 'source.yuv'];
+var RAW_AUDIO = ['-f', 's16le', '-ar', '' + SAMPLE_RATE, '-ac', '2', '-i', 'source.pcm'];
+
+/* Inputs for the timed pipelines, made from the raw sources.  Not timed. */
+var PREPARE = [
+  { output: 'source.webm', inputs: ['source.yuv'],
+    args: RAW_VIDEO.concat(['-c:v', 'libvpx', '-b:v', '1M', '-g', '50', 'source.webm']) },
+  { output: 'source.mp4', inputs: ['source.yuv', 'source.pcm'],
+    args: RAW_VIDEO.concat(RAW_AUDIO, ['-c:v', 'libx264', '-preset', 'veryfast', '-g', '50',
+      '-c:a', 'aac', '-strict', 'experimental', '-b:a', '128k', 'source.mp4']) },
+  { output: 'source.wav', inputs: ['source.pcm'],
+    args: RAW_AUDIO.concat(['source.wav']) }
+];
+
+var PIPELINES = [
+  { name: 'decode_vp8', inputs: ['source.webm'],
+    args: ['-i', 'source.webm', '-f', 'null', '-'] },
+  { name: 'decode_h264', inputs: ['source.mp4'],
+    args: ['-i', 'source.mp4', '-an', '-f', 'null', '-'] },
+  { name: 'transcode_vp8_to_h264', inputs: ['source.webm'],
+    args: ['-i', 'source.webm', '-c:v', 'libx264', '-preset', 'veryfast', 'output.mp4'] },
+  { name: 'transcode_h264_to_vp8', inputs: ['source.mp4'],
+    args: ['-i', 'source.mp4', '-an', '-c:v', 'libvpx', '-b:v', '500k', '-deadline', 'realtime', '-cpu-used', '8', 'output.webm'] },
+  { name: 'scale_to_rgba', inputs: ['source.webm'],
+    args: ['-i', 'source.webm', '-vf', 'scale=320:180', '-pix_fmt', 'rgba', '-f', 'null', '-'] },
+  { name: 'remux_mp4_to_mkv', inputs: ['source.mp4'],
+    args: ['-i', 'source.mp4', '-c', 'copy', 'output.mkv'] },
+  { name: 'encode_aac', inputs: ['source.wav'],
+    args: ['-i', 'source.wav', '-c:a', 'aac', '-strict', 'experimental', '-b:a', '128k', 'output.m4a'] }
+];
+
+/* Two detuned sines, stereo s16le */
+function makeAudio() {
+  var samples = SAMPLE_RATE * SECONDS;
+  var data = new Int16Array(samples * 2);
+  for (var i = 0; i < samples; i++) {
+    var t = i / SAMPLE_RATE;
+    data[2 * i] = 8000 * Math.sin(2 * Math.PI * 440 * t);
+    data[2 * i + 1] = 8000 * Math.sin(2 * Math.PI * 554.37 * t);
+  }
+  return new Uint8Array(data.buffer);
+}
+
+function main(argv) {
+  var target = argv[0], binary = argv[1], filter = argv[2];
+  if ((target !== 'native' && target !== 'wasm') || !binary) {
+    console.error('usage: node run.js native|wasm <ffmpeg binary or .js build> [name filter]');
+    process.exit(2);
+  }
+  var run = common.create(target, binary);
+
+  var files = { 'source.yuv': common.makeVideo(WIDTH, HEIGHT, FPS * SECONDS), 'source.pcm': makeAudio() };
+  PREPARE.forEach(function(step) {
+    var outputs = run(step.args, common.select(files, step.inputs));
+    files[step.output] = outputs[step.output];
+  });
+
+  var results = [];
+  PIPELINES.forEach(function(pipeline) {
+    if (filter && pipeline.name.indexOf(filter) === -1) {
+      return;
+    }
+    var inputs = common.select(files, pipeline.inputs);
+    var best = Infinity;
+    for (var i = 0; i < RUNS; i++) {
+      var start = process.hrtime();
+      run(pipeline.args, inputs);
+      var elapsed = process.hrtime(start);
+      best = Math.min(best, elapsed[0] * 1e3 + elapsed[1] / 1e6);
+    }
+    console.error(pipeline.name + ' ' + best.toFixed(1) + ' ms');
+    results.push({ name: pipeline.name, value: +best.toFixed(2), unit: 'ms', runs: RUNS });
+  });
+
+  console.log(JSON.stringify({ suite: 'macro', target: process.env.BENCH_TARGET || target, results: results }, null, 2));
+}
+
+main(process.argv.slice(2));
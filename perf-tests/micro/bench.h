@@ -0,0 +1,129 @@
+/*
+ * Minimal harness shared by the micro benchmarks.  Every benchmark is a
+ * function that calls the kernel under test a given number of times; the
+ * harness picks an iteration count that runs for about BENCH_TIME
+ * milliseconds, keeps the fastest of a few such runs and prints all results
+ * of a suite as one JSON object on stdout.
+ *
+ * usage: <benchmark> [-t milliseconds] [name filter]
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_RUNS        5
+#define BENCH_MAX_RESULTS 64
+
+/* build_native.sh sets this to native-c or native-asm */
+#ifndef BENCH_TARGET
+#if defined(__EMSCRIPTEN__) && defined(__wasm_simd128__)
+#define BENCH_TARGET "wasm-simd128"
+#elif defined(__EMSCRIPTEN__)
+#define BENCH_TARGET "wasm"
+#else
+#define BENCH_TARGET "native-c"
+#endif
+#endif
+
+typedef void (*bench_fn)(void *ctx, int iterations);
+
+typedef struct BenchResult {
+    const char *name;
+    double ns_per_call;
+    int iterations;
+} BenchResult;
+
+static BenchResult bench_results[BENCH_MAX_RESULTS];
+static int bench_nb_results;
+static double bench_time_ms = 200;
+static const char *bench_filter;
+
+static double bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_init(int argc, char **argv)
+{
+    int i;
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc)
+            bench_time_ms = atof(argv[++i]);
+        else
+            bench_filter = argv[i];
+    }
+}
+
+/* deterministic pseudo-random bytes, so every build sees the same input */
+static void bench_fill(uint8_t *buf, size_t size, uint32_t seed)
+{
+    size_t i;
+    for (i = 0; i < size; i++) {
+        seed = seed * 1664525 + 1013904223;
+        buf[i] = seed >> 24;
+    }
+}
+
+static void bench_run(const char *name, bench_fn fn, void *ctx)
+{
+    double best = 0, start, elapsed;
+    int iterations = 1, run;
+
+    if (bench_filter && !strstr(name, bench_filter))
+        return;
+    if (bench_nb_results == BENCH_MAX_RESULTS) {
+        fprintf(stderr, "too many benchmarks, raise BENCH_MAX_RESULTS\n");
+        exit(1);
+    }
+
+    /* one untimed call first, so lazy initialization and cold caches do not
+     * end up in the calibration; then grow the iteration count until one
+     * run takes a tenth of the budget */
+    fn(ctx, 1);
+    for (;;) {
+        start = bench_now_ns();
+        fn(ctx, iterations);
+        elapsed = bench_now_ns() - start;
+        if (elapsed * 10 >= bench_time_ms * 1e6 / BENCH_RUNS || iterations >= 1 << 30)
+            break;
+        iterations *= 2;
+    }
+    if (elapsed > 0)
+        iterations = (int)(iterations * (bench_time_ms * 1e6 / BENCH_RUNS / elapsed)) + 1;
+
+    for (run = 0; run < BENCH_RUNS; run++) {
+        start = bench_now_ns();
+        fn(ctx, iterations);
+        elapsed = (bench_now_ns() - start) / iterations;
+        if (!run || elapsed < best)
+            best = elapsed;
+    }
+
+    bench_results[bench_nb_results].name        = name;
+    bench_results[bench_nb_results].ns_per_call = best;
+    bench_results[bench_nb_results].iterations  = iterations;
+    bench_nb_results++;
+    fprintf(stderr, "%-32s %12.1f ns\n", name, best);
+}
+
+static void bench_print(const char *suite)
+{
+    int i;
+    printf("{\n  \"suite\": \"%s\",\n  \"target\": \"%s\",\n  \"results\": [\n",
+           suite, BENCH_TARGET);
+    for (i = 0; i < bench_nb_results; i++)
+        printf("    { \"name\": \"%s\", \"value\": %.2f, \"unit\": \"ns/call\", \"iterations\": %d }%s\n",
+               bench_results[i].name, bench_results[i].ns_per_call,
+               bench_results[i].iterations, i + 1 < bench_nb_results ? "," : "");
+    printf("  ]\n}\n");
+}
+
+#endif /* BENCH_H */
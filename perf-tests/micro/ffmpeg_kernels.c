@@ -0,0 +1,242 @@
+/*
+ * Micro benchmarks for the FFmpeg kernels that dominate the WebM and
+ * scaling paths: vp8 motion compensation, idct and loop filter, vp9 loop
+ * filter and swscale.  Built against the configured FFmpeg tree, since the
+ * dsp contexts are internal (see build_native.sh and build_wasm.sh).
+ */
+
+#include "bench.h"
+
+#include "libavcodec/vp8dsp.h"
+#include "libavcodec/vp9dsp.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libswscale/swscale.h"
+
+#define STRIDE 64
+
+typedef struct KernelContext {
+    VP8DSPContext vp8;
+    VP9DSPContext vp9;
+    uint8_t *src;
+    uint8_t *dst;
+    int16_t block[4][16];
+    int16_t coeffs[4][16];
+} KernelContext;
+
+typedef struct ScaleContext {
+    struct SwsContext *sws;
+    uint8_t *src[4], *dst[4];
+    int src_linesize[4], dst_linesize[4];
+    int src_h;
+} ScaleContext;
+
+/* 6-tap filters are used for even subpel positions, 4-tap for odd ones */
+static void vp8_epel16_h6v6(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--)
+        c->vp8.put_vp8_epel_pixels_tab[0][2][2](c->dst, STRIDE, c->src + 2 * STRIDE + 2, STRIDE, 16, 2, 2);
+}
+
+static void vp8_epel16_h4v4(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--)
+        c->vp8.put_vp8_epel_pixels_tab[0][1][1](c->dst, STRIDE, c->src + 2 * STRIDE + 2, STRIDE, 16, 1, 1);
+}
+
+static void vp8_epel8_h6v6(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--)
+        c->vp8.put_vp8_epel_pixels_tab[1][2][2](c->dst, STRIDE, c->src + 2 * STRIDE + 2, STRIDE, 8, 2, 2);
+}
+
+/* the idcts clear the coefficients they consume, so they are refilled
+ * every call; the copy is part of the measured time */
+static void vp8_idct_add(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--) {
+        memcpy(c->block[0], c->coeffs[0], sizeof(c->block[0]));
+        c->vp8.vp8_idct_add(c->dst, c->block[0], STRIDE);
+    }
+}
+
+static void vp8_idct_dc_add4y(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--) {
+        c->block[0][0] = c->coeffs[0][0];
+        c->block[1][0] = c->coeffs[1][0];
+        c->block[2][0] = c->coeffs[2][0];
+        c->block[3][0] = c->coeffs[3][0];
+        c->vp8.vp8_idct_dc_add4y(c->dst, c->block, STRIDE);
+    }
+}
+
+static void vp8_loop_filter16y_v(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--)
+        c->vp8.vp8_v_loop_filter16y(c->dst + 8 * STRIDE, STRIDE, 40, 20, 10);
+}
+
+static void vp8_loop_filter16y_h(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--)
+        c->vp8.vp8_h_loop_filter16y(c->dst + 8, STRIDE, 40, 20, 10);
+}
+
+static void vp8_loop_filter16y_inner_v(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--)
+        c->vp8.vp8_v_loop_filter16y_inner(c->dst + 8 * STRIDE, STRIDE, 40, 20, 10);
+}
+
+static void vp9_loop_filter_16_v(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--)
+        c->vp9.loop_filter_16[1](c->dst + 16 * STRIDE, STRIDE, 40, 20, 10);
+}
+
+static void vp9_loop_filter_16_h(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--)
+        c->vp9.loop_filter_16[0](c->dst + 16, STRIDE, 40, 20, 10);
+}
+
+static void vp9_loop_filter_8_v(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--)
+        c->vp9.loop_filter_8[1][1](c->dst + 16 * STRIDE, STRIDE, 40, 20, 10);
+}
+
+static void vp9_loop_filter_4_h(void *opaque, int n)
+{
+    KernelContext *c = opaque;
+    while (n--)
+        c->vp9.loop_filter_8[0][0](c->dst + 16, STRIDE, 40, 20, 10);
+}
+
+static void sws_picture(void *opaque, int n)
+{
+    ScaleContext *s = opaque;
+    while (n--)
+        sws_scale(s->sws, (const uint8_t * const *)s->src, s->src_linesize,
+                  0, s->src_h, s->dst, s->dst_linesize);
+}
+
+static int init_scale(ScaleContext *s, int src_w, int src_h, int dst_w, int dst_h,
+                      enum AVPixelFormat dst_fmt, int flags)
+{
+    int i;
+
+    memset(s, 0, sizeof(*s));
+    s->src_h = src_h;
+    s->sws   = sws_getContext(src_w, src_h, AV_PIX_FMT_YUV420P,
+                              dst_w, dst_h, dst_fmt, flags, NULL, NULL, NULL);
+    if (!s->sws)
+        return -1;
+
+    s->src_linesize[0] = FFALIGN(src_w, 32);
+    s->src_linesize[1] = s->src_linesize[2] = FFALIGN(src_w / 2, 32);
+    for (i = 0; i < 3; i++) {
+        int size = s->src_linesize[i] * (i ? src_h / 2 : src_h);
+        s->src[i] = av_malloc(size);
+        if (!s->src[i])
+            return -1;
+        bench_fill(s->src[i], size, 1234 + i);
+    }
+
+    if (dst_fmt == AV_PIX_FMT_RGBA) {
+        s->dst_linesize[0] = FFALIGN(dst_w * 4, 32);
+        s->dst[0] = av_malloc(s->dst_linesize[0] * dst_h);
+        return s->dst[0] ? 0 : -1;
+    }
+    s->dst_linesize[0] = FFALIGN(dst_w, 32);
+    s->dst_linesize[1] = s->dst_linesize[2] = FFALIGN(dst_w / 2, 32);
+    for (i = 0; i < 3; i++) {
+        s->dst[i] = av_malloc(s->dst_linesize[i] * (i ? dst_h / 2 : dst_h));
+        if (!s->dst[i])
+            return -1;
+    }
+    return 0;
+}
+
+static void uninit_scale(ScaleContext *s)
+{
+    int i;
+    sws_freeContext(s->sws);
+    for (i = 0; i < 4; i++) {
+        av_free(s->src[i]);
+        av_free(s->dst[i]);
+    }
+}
+
+static void run_scale(const char *name, int src_w, int src_h, int dst_w, int dst_h,
+                      enum AVPixelFormat dst_fmt, int flags)
+{
+    ScaleContext s;
+    if (init_scale(&s, src_w, src_h, dst_w, dst_h, dst_fmt, flags) < 0) {
+        fprintf(stderr, "%s: could not set up swscale\n", name);
+        exit(1);
+    }
+    bench_run(name, sws_picture, &s);
+    uninit_scale(&s);
+}
+
+int main(int argc, char **argv)
+{
+    KernelContext c;
+    int i, j;
+
+    bench_init(argc, argv);
+    /* swscale warns about the missing accelerated converters in C builds */
+    av_log_set_level(AV_LOG_ERROR);
+
+    memset(&c, 0, sizeof(c));
+    ff_vp78dsp_init(&c.vp8);
+    ff_vp8dsp_init(&c.vp8);
+    ff_vp9dsp_init(&c.vp9);
+    c.src = av_malloc(STRIDE * STRIDE);
+    c.dst = av_malloc(STRIDE * STRIDE);
+    if (!c.src || !c.dst)
+        return 1;
+    bench_fill(c.src, STRIDE * STRIDE, 1);
+    bench_fill(c.dst, STRIDE * STRIDE, 2);
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 16; j++)
+            c.coeffs[i][j] = ((i * 16 + j) * 37 % 64) - 32;
+
+    bench_run("vp8_epel16_h6v6", vp8_epel16_h6v6, &c);
+    bench_run("vp8_epel16_h4v4", vp8_epel16_h4v4, &c);
+    bench_run("vp8_epel8_h6v6", vp8_epel8_h6v6, &c);
+    bench_run("vp8_idct_add", vp8_idct_add, &c);
+    bench_run("vp8_idct_dc_add4y", vp8_idct_dc_add4y, &c);
+    bench_run("vp8_loop_filter16y_v", vp8_loop_filter16y_v, &c);
+    bench_run("vp8_loop_filter16y_h", vp8_loop_filter16y_h, &c);
+    bench_run("vp8_loop_filter16y_inner_v", vp8_loop_filter16y_inner_v, &c);
+    bench_run("vp9_loop_filter_16_v", vp9_loop_filter_16_v, &c);
+    bench_run("vp9_loop_filter_16_h", vp9_loop_filter_16_h, &c);
+    bench_run("vp9_loop_filter_8_v", vp9_loop_filter_8_v, &c);
+    bench_run("vp9_loop_filter_4_h", vp9_loop_filter_4_h, &c);
+
+    /* same size: the unscaled yuv2rgb converter */
+    run_scale("sws_yuv2rgba_640x360", 640, 360, 640, 360, AV_PIX_FMT_RGBA, SWS_BILINEAR);
+    run_scale("sws_bilinear_720p_to_360p", 1280, 720, 640, 360, AV_PIX_FMT_YUV420P, SWS_BILINEAR);
+    run_scale("sws_bicubic_360p_to_720p", 640, 360, 1280, 720, AV_PIX_FMT_YUV420P, SWS_BICUBIC);
+    run_scale("sws_bilinear_720p_to_rgba_160x90", 1280, 720, 160, 90, AV_PIX_FMT_RGBA, SWS_BILINEAR);
+
+    av_free(c.src);
+    av_free(c.dst);
+
+    bench_print("ffmpeg_kernels");
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * Micro benchmarks for x264: the pixel comparison functions the motion
+ * search is built on (common/pixel.c) and the motion search itself
+ * (encoder/me.c), measured as the cost of encoding one frame of a moving
+ * synthetic clip with each search method.  Needs the configured x264 tree
+ * for the internal headers (see build_native.sh and build_wasm.sh).
+ */
+
+#include "bench.h"
+
+#include "common/common.h"
+
+#define ME_WIDTH  320
+#define ME_HEIGHT 240
+#define ME_FRAMES 16
+
+typedef struct PixelContext {
+    x264_pixel_function_t pf;
+    pixel *fenc;
+    pixel *ref;
+} PixelContext;
+
+typedef struct MeContext {
+    x264_t *enc;
+    x264_picture_t pic[ME_FRAMES];
+    int64_t pts;
+} MeContext;
+
+#define PIXEL_BENCH(name, cmp, size)                                         \
+static void name(void *opaque, int n)                                        \
+{                                                                            \
+    PixelContext *c = opaque;                                                \
+    volatile int sum = 0;                                                    \
+    while (n--)                                                              \
+        sum += c->pf.cmp[size](c->fenc, FENC_STRIDE, c->ref + n % 8, FDEC_STRIDE); \
+}
+
+PIXEL_BENCH(sad_16x16,  sad,  PIXEL_16x16)
+PIXEL_BENCH(sad_8x8,    sad,  PIXEL_8x8)
+PIXEL_BENCH(satd_16x16, satd, PIXEL_16x16)
+PIXEL_BENCH(satd_8x8,   satd, PIXEL_8x8)
+PIXEL_BENCH(satd_4x4,   satd, PIXEL_4x4)
+PIXEL_BENCH(sa8d_16x16, sa8d, PIXEL_16x16)
+
+static void sad_x4_16x16(void *opaque, int n)
+{
+    PixelContext *c = opaque;
+    int scores[4];
+    while (n--)
+        c->pf.sad_x4[PIXEL_16x16](c->fenc, c->ref, c->ref + 1, c->ref + 2, c->ref + 3,
+                                  FDEC_STRIDE, scores);
+}
+
+static void me_encode(void *opaque, int n)
+{
+    MeContext *c = opaque;
+    x264_picture_t out;
+    x264_nal_t *nal;
+    int nb_nal;
+
+    while (n--) {
+        x264_picture_t *pic = &c->pic[c->pts % ME_FRAMES];
+        pic->i_pts = c->pts++;
+        if (x264_encoder_encode(c->enc, &nal, &nb_nal, pic, &out) < 0) {
+            fprintf(stderr, "x264_encoder_encode failed\n");
+            exit(1);
+        }
+    }
+}
+
+/* A textured plane panning diagonally, so every search has real motion to
+ * find, plus a little noise so the frames are not exact copies. */
+static int init_me(MeContext *c, int method)
+{
+    x264_param_t param;
+    uint8_t texture[(ME_WIDTH + ME_FRAMES * 3) * (ME_HEIGHT + ME_FRAMES * 2)];
+    int tex_stride = ME_WIDTH + ME_FRAMES * 3;
+    int i, y;
+
+    memset(c, 0, sizeof(*c));
+    bench_fill(texture, sizeof(texture), 99);
+    for (i = 1; i < (int)sizeof(texture) - 1; i++)
+        texture[i] = (texture[i - 1] + 2 * texture[i] + texture[i + 1]) >> 2;
+
+    if (x264_param_default_preset(&param, "veryfast", "zerolatency") < 0)
+        return -1;
+    param.i_width         = ME_WIDTH;
+    param.i_height        = ME_HEIGHT;
+    param.i_threads       = 1;
+    param.i_keyint_max    = X264_KEYINT_MAX_INFINITE;
+    param.i_log_level     = X264_LOG_NONE;
+    param.analyse.i_me_method = method;
+    param.analyse.i_me_range  = 16;
+    param.analyse.i_subpel_refine = 2;
+    param.rc.i_rc_method  = X264_RC_CQP;
+    param.rc.i_qp_constant = 26;
+    if (!(c->enc = x264_encoder_open(&param)))
+        return -1;
+
+    for (i = 0; i < ME_FRAMES; i++) {
+        x264_picture_t *pic = &c->pic[i];
+        if (x264_picture_alloc(pic, X264_CSP_I420, ME_WIDTH, ME_HEIGHT) < 0)
+            return -1;
+        for (y = 0; y < ME_HEIGHT; y++)
+            memcpy(pic->img.plane[0] + y * pic->img.i_stride[0],
+                   texture + (y + i * 2) * tex_stride + i * 3, ME_WIDTH);
+        bench_fill(pic->img.plane[0], ME_WIDTH / 4, i);
+        memset(pic->img.plane[1], 128, pic->img.i_stride[1] * ME_HEIGHT / 2);
+        memset(pic->img.plane[2], 128, pic->img.i_stride[2] * ME_HEIGHT / 2);
+    }
+    return 0;
+}
+
+static void uninit_me(MeContext *c)
+{
+    int i;
+    for (i = 0; i < ME_FRAMES; i++)
+        x264_picture_clean(&c->pic[i]);
+    x264_encoder_close(c->enc);
+}
+
+static void run_me(const char *name, int method)
+{
+    MeContext c;
+    if (init_me(&c, method) < 0) {
+        fprintf(stderr, "%s: could not open the encoder\n", name);
+        exit(1);
+    }
+    bench_run(name, me_encode, &c);
+    uninit_me(&c);
+}
+
+int main(int argc, char **argv)
+{
+    PixelContext c;
+
+    bench_init(argc, argv);
+
+    memset(&c, 0, sizeof(c));
+    x264_pixel_init(x264_cpu_detect(), &c.pf);
+    c.fenc = x264_malloc(FENC_STRIDE * 16 * sizeof(pixel));
+    c.ref  = x264_malloc(FDEC_STRIDE * 24 * sizeof(pixel));
+    if (!c.fenc || !c.ref)
+        return 1;
+    bench_fill((uint8_t *)c.fenc, FENC_STRIDE * 16 * sizeof(pixel), 1);
+    bench_fill((uint8_t *)c.ref, FDEC_STRIDE * 24 * sizeof(pixel), 2);
+
+    bench_run("x264_sad_16x16", sad_16x16, &c);
+    bench_run("x264_sad_8x8", sad_8x8, &c);
+    bench_run("x264_sad_x4_16x16", sad_x4_16x16, &c);
+    bench_run("x264_satd_16x16", satd_16x16, &c);
+    bench_run("x264_satd_8x8", satd_8x8, &c);
+    bench_run("x264_satd_4x4", satd_4x4, &c);
+    bench_run("x264_sa8d_16x16", sa8d_16x16, &c);
+
+    x264_free(c.fenc);
+    x264_free(c.ref);
+
+    /* ns/call is per encoded frame here */
+    run_me("x264_me_dia_320x240", X264_ME_DIA);
+    run_me("x264_me_hex_320x240", X264_ME_HEX);
+    run_me("x264_me_umh_320x240", X264_ME_UMH);
+
+    bench_print("x264_kernels");
+    return 0;
+}
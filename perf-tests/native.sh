@@ -1 +1,7 @@
-time ./ffmpeg_native -i big_buck_bunny.webm -vf showinfo,scale=w=-1:h=-1 -strict experimental -v verbose output.mov
+# Native baseline for the emscripten numbers: builds the libraries natively
+# once (see build_native.sh) and runs the benchmark suite against them.
+cd "$(dirname "$0")"
+if [ ! -x native/ffmpeg/ffmpeg ]; then
+  ./build_native.sh || exit 1
+fi
+./run.sh native
@@ -0,0 +1,53 @@
+# Runs the micro and macro benchmarks for one target and writes one JSON file
+# per suite to results/<target>, for compare.js.
+#
+#   ./run.sh native          after build_native.sh
+#   ./run.sh wasm            after build_wasm.sh and SIMD128=0 ../build/build_all_codecs.sh
+#   ./run.sh wasm-simd128    after build_wasm.sh and ../build/build_all_codecs.sh
+#
+# The wasm targets only run the macro benchmarks when ffmpeg-all-codecs.js was
+# built the same way, so scalar and SIMD128 results never share a label.
+set -e
+cd "$(dirname "$0")"
+
+TARGET=$1
+OUT=results/$TARGET
+
+case "$TARGET" in
+  native)
+    FFMPEG=native/ffmpeg/ffmpeg
+    RUNNER=native
+    RUN=""
+    BENCH=native/bench
+    EXT=""
+    LABEL=$(cat native/target 2>/dev/null || echo native-c)
+    MACRO=$LABEL
+    ;;
+  wasm|wasm-simd128)
+    FFMPEG=../build/ffmpeg-all-codecs.js
+    RUNNER=wasm
+    RUN=node
+    [ "$TARGET" = "wasm" ] && BENCH=wasm/scalar/bench || BENCH=wasm/simd128/bench
+    EXT=.js
+    LABEL=$TARGET
+    MACRO=$(cat ../build/ffmpeg-all-codecs.target 2>/dev/null || echo unknown)
+    ;;
+  *)
+    echo "usage: $0 native|wasm|wasm-simd128" >&2
+    exit 2
+    ;;
+esac
+
+mkdir -p $OUT
+for suite in ffmpeg_kernels x264_kernels; do
+  $RUN $BENCH/$suite$EXT > $OUT/$suite.json
+done
+if [ "$MACRO" = "$LABEL" ]; then
+  BENCH_TARGET=$LABEL node macro/run.js $RUNNER $FFMPEG > $OUT/macro.json
+  BENCH_TARGET=$LABEL node macro/memory.js $RUNNER $FFMPEG > $OUT/memory.json
+else
+  echo "$FFMPEG is a $MACRO build, skipping the macro benchmarks for $LABEL" >&2
+  rm -f $OUT/macro.json $OUT/memory.json
+fi
+
+echo "Results in $OUT"
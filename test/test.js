@@ -5,6 +5,20 @@ test ("Ping", function() {
 
 asyncTest("Basic worker is initialized", basicWorkerTest("../demo/worker.js"));
 asyncTest("All codecs worker is initialized", basicWorkerTest("../demo/worker-asm.js"));
+asyncTest("Threaded worker output matches single threaded output", threadedOutputTest);
+asyncTest("Threaded worker refuses jobs larger than its pool", threadedPoolSizeTest);
+asyncTest("Jobs fail when the heap cannot grow to TOTAL_MEMORY", heapReserveTest);
+asyncTest("Streamed input and output match MEMFS files", streamedOutputTest);
+asyncTest("Jobs run on the same instance produce the same output", repeatedJobTest);
+asyncTest("-cpuflags and -max_alloc do not carry over to the next job", jobDefaultsTest);
+asyncTest("Stream copy to fragmented MP4", fragmentedRemuxTest);
+asyncTest("Segmented transcode matches a serial transcode", segmentedTranscodeTest);
+asyncTest("Segmented transcode reports failed segments", segmentedFailureTest);
+asyncTest("Segmented transcode reports workers that do not load", segmentedWorkerErrorTest);
+asyncTest("Keyframe thumbnails", thumbnailsTest);
+asyncTest("Thumbnail errors are reported", thumbnailsErrorTest);
+asyncTest("Stage timings and memory stats", statsTest);
+asyncTest("Allocations per frame and heap size scaling a 1080p clip", pooledAllocationTest);
 
 function basicWorkerTest(src) {
   return function( assert ) {
@@ -29,6 +43,543 @@ function basicWorkerTest(src) {
   }
 }
 
+/* the worker sizes its pool from the first command, so threads: 4 gets
+   1 * (4 + 1) + 1 workers, what this job needs, on any number of cores */
+function threadedOutputTest() {
+  expect( 3 );
+  var args = ["-i", "input.webm", "-frames:v", "24", "-c:v", "libx264", "-c:a", "copy", "out.mkv"];
+  loadFile("../demo/bigbuckbunny.webm", function(data) {
+    runCommand("../demo/worker-asm.js", { arguments: args, files: [{ name: "input.webm", data: data }] }, function(single) {
+      runCommand("../demo/worker-threaded.js", { arguments: args, files: [{ name: "input.webm", data: data }], threads: 4 }, function(threaded) {
+        equal (threaded.length, 1, "Threaded build produced one output file");
+        equal (threaded[0].data.byteLength, single[0].data.byteLength, "Output sizes match");
+        deepEqual (new Uint8Array(threaded[0].data), new Uint8Array(single[0].data), "Output bytes match");
+        QUnit.start();
+      });
+    });
+  });
+}
+
+/* threads and maxInputs are pinned so that the pool is the same on any
+   number of cores: 1 * (2 + 1) + 1 workers, where two inputs need 7 */
+function threadedPoolSizeTest() {
+  expect( 2 );
+  var errors = [];
+  var args = ["-i", "a.webm", "-i", "b.webm", "-map", "0:v", "-map", "1:a", "-c", "copy", "out.mkv"];
+  loadFile("../demo/bigbuckbunny.webm", function(data) {
+    initWorker({
+      src: "../demo/worker-threaded.js",
+      ready: function(worker) {
+        worker.postMessage({
+          type: "command",
+          arguments: args,
+          files: [{ name: "a.webm", data: data }, { name: "b.webm", data: data }],
+          threads: 2,
+          maxInputs: 1
+        });
+      },
+      onstdout: function(worker, message) {
+        errors.push(message.data);
+      },
+      done: function(worker, message) {
+        worker.terminate();
+        equal (message.data.length, 0, "No output for a job with more inputs than the pool allows");
+        ok (errors.some(function(line) { return line.indexOf("pthreadPoolSize") > -1; }), "The refusal is reported");
+        QUnit.start();
+      }
+    });
+  });
+}
+
+/* the builds grow the heap up to 1GB by default, so 2GB cannot be reserved */
+function heapReserveTest() {
+  expect( 3 );
+  var errors = [];
+  initWorker({
+    src: "../demo/worker-asm.js",
+    ready: function(worker) {
+      worker.postMessage({
+        type: "command",
+        arguments: ["-version"],
+        TOTAL_MEMORY: 2048 * 1024 * 1024
+      });
+    },
+    onstdout: function(worker, message) {
+      errors.push(message.data);
+    },
+    done: function(worker, message) {
+      worker.terminate();
+      equal (message.data.length, 0, "No output");
+      equal (message.exitCode, 1, "The job failed");
+      ok (errors.some(function(line) { return line.indexOf("TOTAL_MEMORY") > -1; }), "The failure is reported");
+      QUnit.start();
+    }
+  });
+}
+
+function streamedOutputTest() {
+  expect( 3 );
+  loadFile("../demo/bigbuckbunny.webm", function(data) {
+    var args = ["-i", "input.webm", "-frames:v", "24", "-c:v", "libx264", "-c:a", "copy", "out.mkv"];
+    runCommand("../demo/worker-asm.js", { arguments: args, files: [{ name: "input.webm", data: data }] }, function(files) {
+      var streamed = new Uint8Array(files[0].data.byteLength);
+      var chunks = 0;
+      initWorker({
+        src: "../demo/worker-asm.js",
+        ready: function(worker) {
+          worker.postMessage({
+            type: "command",
+            arguments: ["-i", "jsstream:input.webm", "-frames:v", "24", "-c:v", "libx264", "-c:a", "copy", "jsstream:out.mkv"],
+            files: [{ name: "input.webm", blob: new Blob([data]) }]
+          });
+        },
+        chunk: function(worker, message) {
+          streamed.set(new Uint8Array(message.data), message.position);
+          chunks++;
+        },
+        done: function(worker, message) {
+          worker.terminate();
+          equal (message.data.length, 0, "Nothing was written to MEMFS");
+          ok (chunks > 0, "Output was delivered in chunks");
+          deepEqual (streamed, new Uint8Array(files[0].data), "Streamed output matches");
+          QUnit.start();
+        }
+      });
+    });
+  });
+}
+
+function repeatedJobTest() {
+  expect( 4 );
+  loadFile("../demo/bigbuckbunny.webm", function(data) {
+    var command = {
+      type: "command",
+      arguments: ["-i", "input.webm", "-frames:v", "24", "-c:v", "libx264", "-c:a", "copy", "out.mkv"],
+      files: [{ name: "input.webm", data: data }]
+    };
+    var results = [];
+    initWorker({
+      src: "../demo/worker-asm.js",
+      ready: function(worker) {
+        worker.postMessage(command);
+      },
+      done: function(worker, message) {
+        results.push(message.data);
+        if (results.length < 2) {
+          worker.postMessage(command);
+          return;
+        }
+        worker.terminate();
+        equal (results[0].length, 1, "First job produced one output file");
+        equal (results[1].length, 1, "Second job produced one output file");
+        equal (results[1][0].name, results[0][0].name, "Output names match");
+        deepEqual (new Uint8Array(results[1][0].data), new Uint8Array(results[0][0].data), "Output bytes match");
+        QUnit.start();
+      }
+    });
+  });
+}
+
+/* -cpuflags and -max_alloc change libavutil state, which has to be put back
+   before the next job.  swscale's print_info names the code it uses, "C"
+   when there are no cpu flags. */
+function jobDefaultsTest() {
+  expect( 4 );
+  loadFile("../demo/bigbuckbunny.webm", function(data) {
+    var scale = ["-i", "input.webm", "-frames:v", "1", "-sws_flags", "bilinear+print_info",
+                 "-vf", "scale=320:180", "-an", "-f", "null", "-"];
+    var jobs = [[], ["-cpuflags", "0"], [], ["-max_alloc", "1000"], []];
+    var caps = [], exitCodes = [];
+    initWorker({
+      src: "../demo/worker-asm.js",
+      ready: function(worker) {
+        next(worker);
+      },
+      onstdout: function(worker, message) {
+        var match = /using (\w+)$/.exec(message.data);
+        if (match && caps.length === exitCodes.length) {
+          caps.push(match[1]);
+        }
+      },
+      done: function(worker, message) {
+        exitCodes.push(message.exitCode);
+        if (caps.length < exitCodes.length) {
+          caps.push(null);
+        }
+        if (exitCodes.length < jobs.length) {
+          next(worker);
+          return;
+        }
+        worker.terminate();
+        equal (caps[1], "C", "-cpuflags 0 turned the optimized code off");
+        equal (caps[2], caps[0], "The next job uses the default cpu flags again (" + caps[0] + ")");
+        notEqual (exitCodes[3], 0, "-max_alloc 1000 made the job fail");
+        equal (exitCodes[4], 0, "The next job has the default allocation limit again");
+        QUnit.start();
+      }
+    });
+    function next(worker) {
+      worker.postMessage({
+        type: "command",
+        arguments: jobs[exitCodes.length].concat(scale),
+        files: [{ name: "input.webm", data: data }]
+      });
+    }
+  });
+}
+
+function fragmentedRemuxTest() {
+  expect( 4 );
+  loadFile("../demo/bigbuckbunny.webm", function(data) {
+    var args = ["-i", "input.webm", "-frames:v", "24", "-c:v", "libx264", "-an", "out.mp4"];
+    runCommand("../demo/worker-asm.js", { arguments: args, files: [{ name: "input.webm", data: data }] }, function(encoded) {
+      var remux = ["-i", "input.mp4", "-c", "copy", "out.mp4"];
+      runCommand("../demo/worker-asm.js", { arguments: remux, files: [{ name: "input.mp4", data: new Uint8Array(encoded[0].data) }], fragmented: true }, function(remuxed) {
+        var boxes = getBoxes(new Uint8Array(remuxed[0].data));
+        equal (boxes[0], "ftyp", "Output starts with ftyp");
+        equal (boxes[1], "moov", "moov comes before the media data");
+        ok (boxes.indexOf("moof") > -1, "Output is fragmented");
+        equal (boxes.filter(function(type) { return type === "moof"; }).length,
+               boxes.filter(function(type) { return type === "mdat"; }).length, "Every fragment has its mdat");
+        QUnit.start();
+      });
+    });
+  });
+}
+
+function segmentedTranscodeTest() {
+  expect( 5 );
+  loadFile("../demo/bigbuckbunny.webm", function(data) {
+    /* a short input with a keyframe every second, so it splits into three segments */
+    var args = ["-i", "input.webm", "-t", "3", "-s", "160x96", "-c:v", "libvpx", "-g", "25", "-an", "short.webm"];
+    runCommand("../demo/worker-asm.js", { arguments: args, files: [{ name: "input.webm", data: data }] }, function(files) {
+      var input = new Uint8Array(files[0].data);
+      var videoArguments = ["-c:v", "libx264"];
+      var serialArgs = ["-i", "short.webm"].concat(videoArguments, ["out.mkv"]);
+      runCommand("../demo/worker-asm.js", { arguments: serialArgs, files: [{ name: "short.webm", data: input }] }, function(serial) {
+        transcodeSegmented({
+          src: "../demo/worker-asm.js",
+          workers: 2,
+          name: "short.webm",
+          data: input,
+          segmentTime: 1,
+          videoArguments: videoArguments,
+          output: "out.mkv"
+        }, function(error, segmented) {
+          equal (error, null, "Segmented transcode succeeded");
+          equal (segmented.length, 1, "Segmented transcode produced one output file");
+          getPackets(serial[0].data, function(serialPackets) {
+            getPackets(segmented[0].data, function(segmentedPackets) {
+              equal (segmentedPackets.length, serialPackets.length, "Frame counts match");
+              deepEqual (sortedPts(segmentedPackets), sortedPts(serialPackets), "Presentation timestamps match");
+              ok (segmentedPackets.every(function(packet, i) {
+                return i === 0 || packet.dts > segmentedPackets[i - 1].dts;
+              }), "Decoding timestamps increase across the joins");
+              QUnit.start();
+            });
+          });
+        });
+      });
+    });
+  });
+}
+
+function segmentedWorkerErrorTest() {
+  expect( 2 );
+  transcodeSegmented({
+    src: "../demo/no-such-worker.js",
+    workers: 2,
+    name: "input.webm",
+    data: new Uint8Array(0),
+    output: "out.mkv",
+    readyTimeout: 10000
+  }, function(error, files) {
+    ok (/no-such-worker\.js/.test(error), "Error names the worker: " + error);
+    equal (files.length, 0, "No output files on failure");
+    QUnit.start();
+  });
+}
+
+function segmentedFailureTest() {
+  expect( 3 );
+  loadFile("../demo/bigbuckbunny.webm", function(data) {
+    transcodeSegmented({
+      src: "../demo/worker-asm.js",
+      workers: 2,
+      name: "input.webm",
+      data: new Uint8Array(data),
+      segmentTime: 1,
+      videoArguments: ["-c:v", "nosuchencoder"],
+      output: "out.mkv"
+    }, function(error, files) {
+      ok (error, "Segmented transcode called back with an error");
+      ok (/^encoding segment\d+\.mkv failed/.test(error), "Error names the failed segment: " + error);
+      equal (files.length, 0, "No output files on failure");
+      QUnit.start();
+    });
+  });
+}
+
+function thumbnailsTest() {
+  expect( 4 );
+  loadFile("../demo/bigbuckbunny.webm", function(data) {
+    initWorker({
+      src: "../demo/worker-asm.js",
+      ready: function(worker) {
+        worker.postMessage({
+          type: "thumbnails",
+          file: { name: "input.webm", data: data },
+          count: 4,
+          width: 160,
+          height: 90
+        });
+      },
+      done: function(worker, message) {
+        worker.terminate();
+        var thumbnails = message.data;
+        equal (thumbnails.length, 4, "Four thumbnails");
+        ok (thumbnails.every(function(thumbnail) {
+          return thumbnail.data.byteLength === 160 * 90 * 4;
+        }), "Thumbnails are 160x90 RGBA");
+        ok (thumbnails.every(function(thumbnail, i) {
+          return i === 0 || thumbnail.time > thumbnails[i - 1].time;
+        }), "Thumbnails come from different keyframes in order");
+        ok (thumbnails.every(function(thumbnail) {
+          var pixels = new Uint8Array(thumbnail.data);
+          for (var i = 3; i < pixels.length; i += 4) {
+            if (pixels[i] !== 255) {
+              return false;
+            }
+          }
+          return true;
+        }), "Thumbnails are opaque");
+        QUnit.start();
+      }
+    });
+  });
+}
+
+/* a file that is not a video, then pictures too large for the heap */
+function thumbnailsErrorTest() {
+  expect( 6 );
+  var requests = [
+    { file: { name: "input.txt", data: new Uint8Array([1, 2, 3, 4]) }, width: 160, height: 90 },
+    { file: { name: "input.txt", data: new Uint8Array([1, 2, 3, 4]) }, width: 30000, height: 30000 }
+  ];
+  var errors = [], done = 0;
+  initWorker({
+    src: "../demo/worker-asm.js",
+    ready: function(worker) {
+      next(worker);
+    },
+    onstdout: function(worker, message) {
+      errors[done] = (errors[done] || "") + message.data + "\n";
+    },
+    done: function(worker, message) {
+      equal (message.data.length, 0, "No thumbnails for request " + done);
+      equal (message.exitCode, 1, "Request " + done + " failed");
+      done++;
+      if (done < requests.length) {
+        next(worker);
+        return;
+      }
+      worker.terminate();
+      ok (/Could not get thumbnails of input\.txt/.test(errors[0]), "Decoding error is reported");
+      ok (/Not enough memory/.test(errors[1]), "Allocation failure is reported");
+      QUnit.start();
+    }
+  });
+  function next(worker) {
+    var request = requests[done];
+    worker.postMessage({
+      type: "thumbnails",
+      file: request.file,
+      count: 4,
+      width: request.width,
+      height: request.height
+    });
+  }
+}
+
+function statsTest() {
+  expect( 10 );
+  loadFile("../demo/bigbuckbunny.webm", function(data) {
+    var reports = [];
+    var command = {
+      type: "command",
+      arguments: ["-i", "input.webm", "-an", "-frames:v", "24", "-c:v", "libx264", "-preset", "ultrafast", "out.mp4"],
+      files: [{ name: "input.webm", data: data }],
+      stats: true,
+      statsPeriod: 0.1
+    };
+    var jobs = 0;
+    initWorker({
+      src: "../demo/worker-asm.js",
+      ready: function(worker) {
+        worker.postMessage(command);
+      },
+      stats: function(worker, message) {
+        reports.push(message.data);
+      },
+      done: function(worker, message) {
+        var last = reports[reports.length - 1];
+        if (++jobs === 2) {
+          /* the second job frees what the first left cached on the
+             instance, but its counts still start from its own beginning */
+          worker.terminate();
+          ok (last.memory.current >= 0, "Current allocation of a later job is not negative");
+          ok (last.memory.peak >= last.memory.current && last.memory.peak > 0, "Peak allocation of a later job is at least the current one");
+          ok (last.memory.allocs > 0, "Allocations of a later job are counted");
+          QUnit.start();
+          return;
+        }
+        ok (reports.length > 0, "Stats were reported");
+        ok (last && last.final, "The last report is the final one");
+        var input = last.inputs.filter(function(stream) {
+          return stream.type === "video";
+        })[0];
+        ok (input.frames > 0 && input.decode_time > 0, "Decoded frames and decode time are reported");
+        equal (last.outputs[0].frames, 24, "Encoded frame count is reported");
+        ok (last.outputs[0].encode_time > 0, "Encode time is reported");
+        ok (last.memory.peak >= last.memory.current && last.memory.peak > 0, "Peak allocation is at least the current one");
+        ok (last.memory.heap >= last.memory.peak, "Heap size covers the peak allocation");
+        reports = [];
+        worker.postMessage(command);
+      }
+    });
+  });
+}
+
+function pooledAllocationTest() {
+  expect( 5 );
+  var frames = 25, short = 5;
+  var encode = ["-f", "rawvideo", "-pix_fmt", "yuv420p", "-s", "1920x1080", "-i", "input.yuv",
+                "-c:v", "libvpx", "-b:v", "4M", "-deadline", "realtime", "-cpu-used", "8", "clip.webm"];
+  runCommand("../demo/worker-asm.js", { arguments: encode, files: [{ name: "input.yuv", data: makeVideo(1920, 1080, frames) }] }, function(files) {
+    var clip = new Uint8Array(files[0].data);
+    scaleStats(clip, frames, function(full) {
+      scaleStats(clip, short, function(part) {
+        /* the difference between both runs leaves out the setup.  This is
+           the scale_1080p_to_720p pipeline of perf-tests/macro/memory.js,
+           where the pools matter most: the filter frames, swscale
+           temporaries and decoder side buffers are all reused.  It made
+           36.2 allocations per frame before pooling and 25.5 after
+           (native), so the bound sits well clear of both.  The pools only
+           cut allocator churn; they keep as many buffers as were live
+           before, and libvpx and libx264 still allocate their own frames,
+           so the peak footprint is not expected to drop and only the heap
+           ceiling is checked. */
+        var perFrame = (full.memory.allocs - part.memory.allocs) / (frames - short);
+        equal (full.inputs[0].frames, frames, "All frames were decoded");
+        equal (part.inputs[0].frames, short, "The shorter run stopped early");
+        ok (part.memory.allocs > 0 && full.memory.allocs > part.memory.allocs, "Allocations were counted");
+        ok (perFrame < 31, "Fewer than 31 allocations per frame (" + perFrame.toFixed(1) + ")");
+        ok (full.memory.heap <= 256 * 1024 * 1024, "Heap stayed within 256MB (" + (full.memory.heap >> 20) + "MB)");
+        QUnit.start();
+      });
+    });
+  });
+}
+
+function scaleStats(clip, frames, cb) {
+  var reports = [];
+  initWorker({
+    src: "../demo/worker-asm.js",
+    ready: function(worker) {
+      worker.postMessage({
+        type: "command",
+        arguments: ["-i", "clip.webm", "-frames:v", String(frames),
+                    "-vf", "scale=1280:720", "-f", "null", "-"],
+        files: [{ name: "clip.webm", data: clip }],
+        stats: true
+      });
+    },
+    stats: function(worker, message) {
+      reports.push(message.data);
+    },
+    done: function(worker, message) {
+      worker.terminate();
+      cb(reports[reports.length - 1]);
+    }
+  });
+}
+
+/* A textured picture panning diagonally, yuv420p */
+function makeVideo(width, height, frames) {
+  var ySize = width * height, cSize = ySize / 4;
+  var data = new Uint8Array(frames * (ySize + 2 * cSize));
+  for (var f = 0, pos = 0; f < frames; f++) {
+    for (var y = 0; y < height; y++) {
+      for (var x = 0; x < width; x++) {
+        data[pos++] = (((x + 3 * f) ^ (y + 2 * f)) & 0x3f) + (((x + 3 * f) >> 3) & 0x7f);
+      }
+    }
+    for (var i = 0; i < 2 * cSize; i++) {
+      data[pos++] = 128 + (i + f) % 64 - 32;
+    }
+  }
+  return data;
+}
+
+/* video packets of a file as listed by the framecrc muxer */
+function getPackets(data, cb) {
+  var args = ["-i", "input.mkv", "-map", "0:v", "-c", "copy", "-f", "framecrc", "packets.txt"];
+  runCommand("../demo/worker-asm.js", { arguments: args, files: [{ name: "input.mkv", data: new Uint8Array(data) }] }, function(files) {
+    var text = String.fromCharCode.apply(null, new Uint8Array(files[0].data));
+    cb(text.split("\n").filter(function(line) {
+      return line.length && line[0] !== "#";
+    }).map(function(line) {
+      var fields = line.split(",");
+      return { dts: parseInt(fields[1], 10), pts: parseInt(fields[2], 10) };
+    }));
+  });
+}
+
+function sortedPts(packets) {
+  return packets.map(function(packet) {
+    return packet.pts;
+  }).sort(function(a, b) {
+    return a - b;
+  });
+}
+
+function getBoxes(data) {
+  var types = [];
+  for (var pos = 0; pos + 8 <= data.length; ) {
+    var size = ((data[pos] << 24) | (data[pos + 1] << 16) | (data[pos + 2] << 8) | data[pos + 3]) >>> 0;
+    types.push(String.fromCharCode(data[pos + 4], data[pos + 5], data[pos + 6], data[pos + 7]));
+    if (size < 8) {
+      break;
+    }
+    pos += size;
+  }
+  return types;
+}
+
+function loadFile(url, cb) {
+  var xhr = new XMLHttpRequest();
+  xhr.open("GET", url, true);
+  xhr.responseType = "arraybuffer";
+  xhr.onload = function() {
+    cb(new Uint8Array(xhr.response));
+  };
+  xhr.send();
+}
+
+function runCommand(src, command, cb) {
+  initWorker({
+    src: src,
+    ready: function(worker) {
+      command.type = "command";
+      worker.postMessage(command);
+    },
+    done: function(worker, message) {
+      worker.terminate();
+      cb(message.data);
+    }
+  });
+}
+
 function initWorker(opts) {
   var src = opts.src;
   var worker = new Worker(src);
@@ -36,6 +587,8 @@ function initWorker(opts) {
   var onstart = opts.start || function() {};
   var ondone = opts.done || function() {};
   var onstdout = opts.onstdout || function() {};
+  var onchunk = opts.chunk || function() {};
+  var onstats = opts.stats || function() {};
   worker.onmessage = function (event) {
     var message = event.data;
     if (message.type == "ready") {
@@ -44,6 +597,10 @@ function initWorker(opts) {
       onstdout(worker, message);
     } else if (message.type == "start") {
       onstart(worker, message);
+    } else if (message.type == "chunk") {
+      onchunk(worker, message);
+    } else if (message.type == "stats") {
+      onstats(worker, message);
     } else if (message.type == "done") {
       ondone(worker, message);
     }